@@ -0,0 +1,162 @@
+// 分发延迟基准：同一批请求分别全部交给线程池和按策略内联处理，报告从
+// dispatch到响应完整到达对端套接字的p50/p99延迟（写经真实的io_uring提交）
+// 构建：cmake -DBUILD_BENCHMARKS=ON ... && cd bin && ./dispatch_latency_bench
+//       [每种请求次数=20000] [线程数=4]
+// 静态根目录按HTTP_STATIC_ROOT相对当前目录解析，在build/bin下运行
+#include "dispatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// 从对端读出一个完整响应（头部加Content-Length字节的响应体）
+static bool read_response(int fd, std::string &buffer) {
+  buffer.clear();
+  char chunk[16384];
+  size_t header_end = std::string::npos;
+  size_t total = 0;
+  while (header_end == std::string::npos || buffer.size() < total) {
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n <= 0) {
+      return false;
+    }
+    buffer.append(chunk, n);
+    if (header_end == std::string::npos) {
+      header_end = buffer.find("\r\n\r\n");
+      if (header_end != std::string::npos) {
+        size_t body = 0;
+        size_t length = buffer.find("Content-Length: ");
+        if (length < header_end) {
+          body = std::strtoull(buffer.c_str() + length + 16, nullptr, 10);
+        }
+        total = header_end + 4 + body;
+      }
+    }
+  }
+  return true;
+}
+
+// 代替事件循环：线程池处理完的请求交回主线程队列，等eventfd唤醒后执行
+static void run_main_tasks(MainThreadTaskQueue &queue, bool pooled) {
+  if (pooled) {
+    struct pollfd wakeup = {queue.wakeup_fd(), POLLIN, 0};
+    uint64_t value;
+    if (poll(&wakeup, 1, -1) == 1 &&
+        read(queue.wakeup_fd(), &value, sizeof(value)) != sizeof(value)) {
+      std::fprintf(stderr, "读eventfd失败\n");
+    }
+  }
+  MainThreadTask task(nullptr, nullptr);
+  while (queue.try_pop_task(task)) {
+    task.callback(task.conn);
+  }
+}
+
+struct Latency {
+  double p50;
+  double p99;
+};
+
+static Latency measure(TaskDispatcher &dispatcher, MainThreadTaskQueue &queue,
+                       io_uring *ring, UringConnectionInfo &conn, int peer,
+                       const std::string &request, size_t iterations) {
+  std::vector<double> samples;
+  samples.reserve(iterations);
+  std::string response;
+  for (size_t i = 0; i < iterations; ++i) {
+    conn.reset();
+    std::memcpy(conn.read_buffer.get_write_tail(), request.data(),
+                request.size());
+    conn.read_buffer.write_data(request.size());
+
+    conn.state = UringConnectionState::READ;
+    auto start = std::chrono::steady_clock::now();
+    if (!dispatcher.dispatch(&conn)) {
+      std::fprintf(stderr, "请求失败: %s\n", request.c_str());
+      std::exit(1);
+    }
+    // 内联处理时写已经提交（连接进入WRITE），否则要等工作线程交回
+    run_main_tasks(queue, conn.state != UringConnectionState::WRITE);
+    if (!read_response(peer, response)) {
+      std::fprintf(stderr, "请求失败: %s\n", request.c_str());
+      std::exit(1);
+    }
+    samples.push_back(std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+
+    // 回收写完成事件，之后连接可以复用
+    struct io_uring_cqe *cqe;
+    if (io_uring_wait_cqe(ring, &cqe) == 0) {
+      io_uring_cqe_seen(ring, cqe);
+    }
+  }
+  std::sort(samples.begin(), samples.end());
+  return Latency{samples[samples.size() / 2],
+                 samples[samples.size() * 99 / 100]};
+}
+
+int main(int argc, char **argv) {
+  size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+  size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+  iterations = std::max<size_t>(iterations, 1);
+  // 请求路径上的日志会淹没结果
+  std::cout.setstate(std::ios::failbit);
+
+  auto ring = std::make_shared<io_uring>();
+  if (io_uring_queue_init(256, ring.get(), 0) < 0) {
+    std::fprintf(stderr, "io_uring初始化失败\n");
+    return 1;
+  }
+  StaticFileCache::instance().preload();
+  StaticPathIndex::instance().build();
+
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+    return 1;
+  }
+  UringConnectionInfo conn;
+  conn.fd = sockets[0];
+
+  auto pool = std::make_shared<ThreadPool>(threads);
+  auto queue = std::make_shared<MainThreadTaskQueue>();
+  if (!queue->enable_wakeup()) {
+    std::fprintf(stderr, "创建eventfd失败\n");
+    return 1;
+  }
+  TaskDispatcher dispatcher(pool, queue, ring);
+  dispatcher.register_handler(
+      std::make_unique<DefaultHttpHandler<UringConnectionInfo>>());
+
+  const char *paths[] = {"/health", "/", "/index.html", "/missing.html"};
+  std::printf("%zu次/请求，%zu个工作线程，单位us\n", iterations, threads);
+  std::printf("%-16s %12s %12s %12s %12s\n", "请求", "线程池p50",
+              "线程池p99", "内联p50", "内联p99");
+  for (const char *path : paths) {
+    std::string request =
+        std::string("GET ") + path + " HTTP/1.1\r\nHost: bench\r\n\r\n";
+    dispatcher.set_inline_enabled(false);
+    Latency pooled =
+        measure(dispatcher, *queue, ring.get(), conn, sockets[1], request,
+                iterations);
+    dispatcher.set_inline_enabled(true);
+    Latency inlined =
+        measure(dispatcher, *queue, ring.get(), conn, sockets[1], request,
+                iterations);
+    std::printf("%-16s %12.2f %12.2f %12.2f %12.2f\n", path, pooled.p50,
+                pooled.p99, inlined.p50, inlined.p99);
+  }
+
+  pool->shutdown();
+  io_uring_queue_exit(ring.get());
+  close(sockets[0]);
+  close(sockets[1]);
+  return 0;
+}
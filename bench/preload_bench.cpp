@@ -0,0 +1,135 @@
+// 启动预加载基准：把根目录全部载入一个新缓存所需的时间（time-to-warm），
+// 对比逐个文件open/fstat/read再生成条目的StaticFileCache::preload与
+// 环上批量读、多线程生成条目的UringPreloader；另外单独对比只读文件的部分
+// 每轮开始前用POSIX_FADV_DONTNEED丢掉文件的页缓存，近似冷启动
+// 构建：cmake -DBUILD_BENCHMARKS=ON ... && ./bin/preload_bench
+//       [根目录=html] [轮数=5] [丢页缓存=1]
+#include "static_file_cache.h"
+#include "uring_preloader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static void drop_page_cache(const std::vector<std::string> &files) {
+  for (const std::string &file : files) {
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+  }
+}
+
+// 对照组的读文件部分：逐个open/fstat/read
+static size_t read_serial(const std::string &root,
+                          const std::vector<std::string> &paths) {
+  size_t bytes = 0;
+  std::string body;
+  for (const std::string &path : paths) {
+    int fd = open((root + path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 &&
+        static_cast<size_t>(st.st_size) <= STATIC_CACHE_MAX_ENTRY) {
+      body.resize(st.st_size);
+      size_t total = 0;
+      while (total < body.size()) {
+        ssize_t n = read(fd, body.data() + total, body.size() - total);
+        if (n <= 0) {
+          break;
+        }
+        total += n;
+      }
+      bytes += total;
+    }
+    close(fd);
+  }
+  return bytes;
+}
+
+template <typename Body> static double time_ms(Body body) {
+  auto start = std::chrono::steady_clock::now();
+  body();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+static double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+int main(int argc, char **argv) {
+  std::string root = argc > 1 ? argv[1] : "html";
+  size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5;
+  bool cold = argc > 3 ? std::atoi(argv[3]) != 0 : true;
+  rounds = std::max<size_t>(rounds, 1);
+
+  // 丢页缓存时连同预压缩文件一起
+  std::vector<std::string> files;
+  size_t total_bytes = 0;
+  for (const auto &item : fs::recursive_directory_iterator(root)) {
+    if (item.is_regular_file()) {
+      files.push_back(item.path().string());
+      total_bytes += item.file_size();
+    }
+  }
+  std::vector<std::string> paths = StaticFileCache(root, 0).list_files();
+  if (paths.empty()) {
+    std::fprintf(stderr, "%s下没有文件\n", root.c_str());
+    return 1;
+  }
+  std::printf("%zu个文件，共%.1fKB，%zu轮，%s\n", paths.size(),
+              total_bytes / 1024.0, rounds, cold ? "每轮丢页缓存" : "热页缓存");
+
+  std::vector<double> serial_read, ring_read, serial_warm, ring_warm;
+  size_t loaded = 0;
+  size_t submits = 0;
+  for (size_t round = 0; round < rounds; ++round) {
+    if (cold) {
+      drop_page_cache(files);
+    }
+    serial_read.push_back(time_ms([&] { read_serial(root, paths); }));
+
+    if (cold) {
+      drop_page_cache(files);
+    }
+    serial_warm.push_back(time_ms([&] {
+      StaticFileCache cache(root, STATIC_CACHE_BUDGET);
+      cache.preload();
+    }));
+
+    if (cold) {
+      drop_page_cache(files);
+    }
+    StaticFileCache cache(root, STATIC_CACHE_BUDGET);
+    UringPreloader preloader(cache);
+    if (!preloader.init()) {
+      return 1;
+    }
+    preloader.run();
+    ring_read.push_back(preloader.stats().read_ms);
+    ring_warm.push_back(preloader.stats().total_ms);
+    loaded = preloader.stats().loaded;
+    submits = preloader.stats().submits;
+  }
+
+  std::printf("读文件    逐个 %9.2fms   环上批量 %9.2fms   (%zu次提交)\n",
+              median(serial_read), median(ring_read), submits);
+  std::printf("载入缓存  逐个 %9.2fms   环上批量 %9.2fms   (%zu个文件)\n",
+              median(serial_warm), median(ring_warm), loaded);
+  return 0;
+}
@@ -0,0 +1,110 @@
+// 请求路径全局堆分配计数：稳态下每个请求的解析+响应以及交给线程池都应为0次分配
+// 构建：cmake -DBUILD_BENCHMARKS=ON ... && ./bin/request_alloc_bench
+// 有分配时返回非0，可直接用作回归检查
+#include "pthread_pool.h"
+#include "taskHander.h"
+#include "uring_types.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+static std::atomic<size_t> g_allocations{0};
+
+void *operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+// 把请求放进连接读缓冲区并走一遍完整的处理器路径
+static void run_once(DefaultHttpHandler<UringConnectionInfo> &handler,
+                     UringConnectionInfo &conn, const char *request) {
+  size_t len = std::strlen(request);
+  std::memcpy(conn.read_buffer.get_write_tail(), request, len);
+  conn.read_buffer.write_data(len);
+  if (handler.is_parse_complete(&conn)) {
+    conn.parse_result = ParseResult::COMPLETE;
+    handler.handle(&conn);
+  }
+  // 模拟写完成
+  conn.write_buffer.read_data(conn.write_buffer.get_readable_size());
+  conn.read_buffer.clear();
+  conn.write_buffer.clear();
+}
+
+int main() {
+  static const char *requests[] = {
+      "GET / HTTP/1.1\r\nHost: localhost:2025\r\nUser-Agent: Mozilla/5.0 "
+      "(X11; Linux x86_64)\r\nAccept: text/html,application/xhtml+xml\r\n"
+      "Accept-Language: zh-CN,zh;q=0.9\r\nConnection: keep-alive\r\n\r\n",
+      "GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n",
+      "POST /submit HTTP/1.1\r\nHost: localhost\r\nContent-Type: "
+      "application/json\r\nContent-Length: 17\r\n\r\n{\"key\": \"value\"}\n",
+      "DELETE /item HTTP/1.1\r\nHost: localhost\r\n\r\n",
+  };
+  constexpr size_t kWarmup = 16;
+  constexpr size_t kIterations = 10000;
+
+  // 处理器日志写到cout，这里静默掉
+  std::cout.setstate(std::ios::failbit);
+
+  UringConnectionInfo conn;
+  DefaultHttpHandler<UringConnectionInfo> handler;
+  int failures = 0;
+  for (const char *request : requests) {
+    for (size_t i = 0; i < kWarmup; ++i) {
+      run_once(handler, conn, request);
+    }
+    size_t before = g_allocations.load();
+    for (size_t i = 0; i < kIterations; ++i) {
+      run_once(handler, conn, request);
+    }
+    size_t allocations = g_allocations.load() - before;
+    const char *line_end = std::strstr(request, "\r\n");
+    std::printf("%-28.*s allocations/request = %.3f\n",
+                int(line_end - request), request,
+                double(allocations) / kIterations);
+    if (allocations != 0) {
+      failures++;
+    }
+  }
+
+  // 交给线程池处理：和分发器一样只提交捕获几个指针的任务，节点复用后
+  // 提交和执行都不应分配
+  ThreadPool pool(2);
+  std::atomic<bool> done{false};
+  const char *request = requests[1];
+  auto submit_once = [&] {
+    done.store(false, std::memory_order_relaxed);
+    pool.post([&handler, &conn, &done, request] {
+      run_once(handler, conn, request);
+      done.store(true, std::memory_order_release);
+    });
+    while (!done.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  };
+  for (size_t i = 0; i < kWarmup; ++i) {
+    submit_once();
+  }
+  size_t before = g_allocations.load();
+  for (size_t i = 0; i < kIterations; ++i) {
+    submit_once();
+  }
+  size_t allocations = g_allocations.load() - before;
+  std::printf("%-28s allocations/request = %.3f\n", "ThreadPool::post",
+              double(allocations) / kIterations);
+  if (allocations != 0) {
+    failures++;
+  }
+  pool.shutdown();
+  return failures == 0 ? 0 : 1;
+}
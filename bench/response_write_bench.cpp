@@ -0,0 +1,59 @@
+// 响应序列化微基准：小响应就地写入缓冲区，报告ns/响应
+// 构建：cmake -DBUILD_BENCHMARKS=ON ... && ./bin/response_write_bench [次数]
+#include "http_response.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char **argv) {
+  size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  static char buffer[4096];
+
+  struct Case {
+    const char *name;
+    HttpResponse response;
+  };
+  Case cases[3];
+  cases[0].name = "200 text/plain";
+  cases[0].response.content_type = HttpMime::PLAIN;
+  cases[0].response.set_body("Hello World!");
+  cases[1].name = "404 close";
+  cases[1].response.status = HttpStatus::NOT_FOUND;
+  cases[1].response.content_type = HttpMime::PLAIN;
+  cases[1].response.keep_alive = false;
+  cases[1].response.set_body("Not Found");
+  cases[2].name = "200 file headers";
+  cases[2].response.content_type = HttpMime::PNG;
+  cases[2].response.set_content_length(1843200);
+  cases[2].response.add_header("ETag", "\"1c2000-65f1a2b3\"");
+  cases[2].response.add_header("Last-Modified",
+                               "Tue, 14 May 2024 08:12:31 GMT");
+
+  std::printf("%-18s %12s %10s\n", "response", "ns/response", "bytes");
+  for (Case &c : cases) {
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      HttpResponseWriter writer(buffer, sizeof(buffer));
+      writer.write_headers(c.response);
+      writer.write_body(c.response.body);
+      sink += writer.size() + static_cast<unsigned char>(buffer[i & 63]);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns =
+        std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+
+    HttpResponseWriter writer(buffer, sizeof(buffer));
+    writer.write_headers(c.response);
+    std::printf("%-18s %12.1f %10zu   (sink=%zu)\n", c.name, ns, writer.size(),
+                sink);
+  }
+
+  HttpResponseWriter writer(buffer, sizeof(buffer));
+  writer.write_headers(cases[0].response);
+  writer.write_body(cases[0].response.body);
+  std::printf("\n%.*s\n", static_cast<int>(writer.size()), buffer);
+  return 0;
+}
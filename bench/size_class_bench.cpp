@@ -0,0 +1,117 @@
+// 尺寸分级对象池 vs malloc：吞吐与碎片对比
+// 构建：cmake -DBUILD_BENCHMARKS=ON ... && ./bin/size_class_bench [轮数]
+#include "../lib/cache_pool/slab_pool/size_class_pool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <random>
+#include <vector>
+
+// 伙伴系统最小块（与uring_types.h中MIN_BLOCK_SIZE一致）
+static constexpr size_t kBuddyMinBlock = 4 * 1024;
+static constexpr size_t kLiveObjects = 50000;
+
+// 近似HTTP场景的对象尺寸分布：大量小对象，少量KB级
+static std::vector<size_t> make_sizes(size_t n) {
+  std::mt19937 rng(2025);
+  std::discrete_distribution<int> bucket({40, 30, 20, 8, 2});
+  std::vector<size_t> sizes(n);
+  for (auto &s : sizes) {
+    switch (bucket(rng)) {
+    case 0:
+      s = 16 + rng() % 48; // 小字符串、请求头节点
+      break;
+    case 1:
+      s = 64 + rng() % 64; // 请求/响应对象
+      break;
+    case 2:
+      s = 128 + rng() % 384; // 请求行、头部值
+      break;
+    case 3:
+      s = 512 + rng() % 512;
+      break;
+    default:
+      s = 1024 + rng() % 1024; // 小响应体
+      break;
+    }
+  }
+  return sizes;
+}
+
+template <typename Alloc, typename Free>
+static double churn(const std::vector<size_t> &sizes, size_t rounds,
+                    Alloc alloc, Free release) {
+  std::vector<void *> live(kLiveObjects, nullptr);
+  std::mt19937 rng(7);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kLiveObjects; ++i) {
+    live[i] = alloc(sizes[i % sizes.size()]);
+  }
+  // 随机替换存活对象，模拟连接上请求对象的生灭
+  for (size_t r = 0; r < rounds; ++r) {
+    size_t slot = rng() % kLiveObjects;
+    release(live[slot], sizes[slot % sizes.size()]);
+    live[slot] = alloc(sizes[slot % sizes.size()]);
+  }
+  auto end = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kLiveObjects; ++i) {
+    release(live[i], sizes[i % sizes.size()]);
+  }
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+  return ns / double(kLiveObjects + rounds);
+}
+
+int main(int argc, char **argv) {
+  size_t rounds = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+  std::vector<size_t> sizes = make_sizes(kLiveObjects);
+
+  size_t requested = 0;
+  size_t malloc_usable = 0;
+  size_t buddy_reserved = 0;
+  for (size_t s : sizes) {
+    requested += s;
+    void *p = std::malloc(s);
+    malloc_usable += malloc_usable_size(p);
+    std::free(p);
+    size_t block = kBuddyMinBlock;
+    while (block < s) {
+      block *= 2;
+    }
+    buddy_reserved += block;
+  }
+
+  double malloc_ns = churn(
+      sizes, rounds, [](size_t s) { return std::malloc(s); },
+      [](void *p, size_t) { std::free(p); });
+
+  SizeClassPool pool;
+  double pool_ns = churn(
+      sizes, rounds, [&pool](size_t s) { return pool.allocate(s); },
+      [&pool](void *p, size_t) { pool.deallocate(p); });
+
+  // 碎片：存活对象全部分配后，保留内存相对请求字节的放大倍数
+  std::vector<void *> live;
+  live.reserve(sizes.size());
+  for (size_t s : sizes) {
+    live.push_back(pool.allocate(s));
+  }
+  size_t pool_reserved = pool.get_reserved_bytes();
+  size_t pool_active = pool.get_active_bytes();
+  for (void *p : live) {
+    pool.deallocate(p);
+  }
+
+  std::printf("objects=%zu rounds=%zu\n", kLiveObjects, rounds);
+  std::printf("%-14s %12s %16s %10s\n", "allocator", "ns/op", "reserved(B)",
+              "overhead");
+  std::printf("%-14s %12.1f %16zu %9.2fx\n", "malloc", malloc_ns,
+              malloc_usable, double(malloc_usable) / requested);
+  std::printf("%-14s %12.1f %16zu %9.2fx (active %zu)\n", "size_class",
+              pool_ns, pool_reserved, double(pool_reserved) / requested,
+              pool_active);
+  std::printf("%-14s %12s %16zu %9.2fx\n", "buddy(4KB min)", "-",
+              buddy_reserved, double(buddy_reserved) / requested);
+  return 0;
+}
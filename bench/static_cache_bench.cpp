@@ -0,0 +1,161 @@
+// 静态文件缓存基准：对html目录按Zipf分布发请求，报告命中率和吞吐，
+// 并与每次open/fstat/read的直接读文件对比；冷启动时所有线程同时请求
+// 同一批文件，检查未命中合并（loads应等于文件数）
+// 构建：cmake -DBUILD_BENCHMARKS=ON ... && ./bin/static_cache_bench
+//       [根目录=html] [线程数=4] [每线程请求数=200000] [预算MB=64]
+#include "static_file_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// 按Zipf(s=1)分布选文件：少数热门资源占大多数请求
+class ZipfPicker {
+private:
+  std::vector<double> cdf_;
+
+public:
+  explicit ZipfPicker(size_t n) : cdf_(n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+      sum += 1.0 / (i + 1);
+      cdf_[i] = sum;
+    }
+    for (double &value : cdf_) {
+      value /= sum;
+    }
+  }
+
+  size_t pick(std::mt19937_64 &rng) const {
+    double u = std::uniform_real_distribution<double>(0, 1)(rng);
+    return std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+  }
+};
+
+// 对照组：每个请求都打开并读完整个文件
+static size_t read_file(const std::string &path, std::vector<char> &buffer) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return 0;
+  }
+  struct stat st;
+  size_t total = 0;
+  if (fstat(fd, &st) == 0) {
+    buffer.resize(st.st_size);
+    while (total < buffer.size()) {
+      ssize_t n = read(fd, buffer.data() + total, buffer.size() - total);
+      if (n <= 0) {
+        break;
+      }
+      total += n;
+    }
+  }
+  close(fd);
+  return total;
+}
+
+template <typename Body>
+static double run_threads(size_t threads, size_t per_thread, Body body) {
+  std::atomic<bool> go{false};
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      while (!go.load(std::memory_order_acquire)) {
+      }
+      body(t, per_thread);
+    });
+  }
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+int main(int argc, char **argv) {
+  std::string root = argc > 1 ? argv[1] : "html";
+  size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+  size_t per_thread = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 200000;
+  size_t budget =
+      (argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 64) * 1024 * 1024;
+
+  std::vector<std::string> paths;
+  size_t total_bytes = 0;
+  for (const auto &item : fs::recursive_directory_iterator(root)) {
+    if (item.is_regular_file()) {
+      paths.push_back("/" + fs::relative(item.path(), root).string());
+      total_bytes += item.file_size();
+    }
+  }
+  if (paths.empty()) {
+    std::fprintf(stderr, "%s下没有文件\n", root.c_str());
+    return 1;
+  }
+  std::printf("%zu个文件，共%.1fKB，预算%.1fMB，%zu线程\n", paths.size(),
+              total_bytes / 1024.0, budget / 1048576.0, threads);
+
+  StaticFileCache cache(root, budget);
+
+  // 冷启动：所有线程按相同顺序请求全部文件
+  double cold = run_threads(threads, 1, [&](size_t, size_t) {
+    for (const std::string &path : paths) {
+      cache.get(path);
+    }
+  });
+  StaticFileCache::Stats stats = cache.stats();
+  std::printf("冷启动  %8.2fms  loads=%zu coalesced=%zu entries=%zu\n",
+              cold * 1e3, stats.loads, stats.coalesced, stats.entries);
+
+  ZipfPicker picker(paths.size());
+  std::atomic<size_t> sink{0};
+
+  size_t direct_per_thread = std::max<size_t>(per_thread / 20, 1);
+  double direct = run_threads(threads, direct_per_thread, [&](size_t t,
+                                                              size_t n) {
+    std::mt19937_64 rng(t + 1);
+    std::vector<char> buffer;
+    size_t bytes = 0;
+    for (size_t i = 0; i < n; ++i) {
+      bytes += read_file(root + paths[picker.pick(rng)], buffer);
+    }
+    sink.fetch_add(bytes);
+  });
+
+  StaticFileCache::Stats before = cache.stats();
+  double cached = run_threads(threads, per_thread, [&](size_t t, size_t n) {
+    std::mt19937_64 rng(t + 1);
+    size_t bytes = 0;
+    for (size_t i = 0; i < n; ++i) {
+      StaticFileCache::EntryPtr entry = cache.get(paths[picker.pick(rng)]);
+      bytes += entry ? entry->identity().body.size() : 0;
+    }
+    sink.fetch_add(bytes);
+  });
+  StaticFileCache::Stats after = cache.stats();
+
+  size_t hits = after.hits - before.hits;
+  size_t misses = after.misses - before.misses;
+  std::printf("直接读文件 %12.0f req/s\n",
+              threads * direct_per_thread / direct);
+  std::printf("缓存       %12.0f req/s  命中率=%.2f%% loads=%zu "
+              "evictions=%zu bytes=%.1fKB   (sink=%zu)\n",
+              threads * per_thread / cached,
+              100.0 * hits / std::max<size_t>(hits + misses, 1),
+              after.loads - before.loads, after.evictions, after.bytes / 1024.0,
+              sink.load());
+  return 0;
+}
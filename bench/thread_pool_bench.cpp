@@ -0,0 +1,192 @@
+// 线程池基准：工作窃取线程池对比原来的单队列（一把锁加条件变量）线程池
+// 吞吐：外部线程连续提交小任务，以及工作线程里再派生子任务（扇出）；
+// 延迟：外部线程提交一个任务后等它开始执行，报告p50/p99
+// 构建：cmake -DBUILD_BENCHMARKS=ON ... && ./bin/thread_pool_bench
+//       [每轮任务数=200000] [延迟采样数=20000] [最大线程数=64]
+#include "pthread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// 改造前的线程池（去掉了每个任务的日志），只保留基准用到的接口
+class LegacyThreadPool {
+private:
+  std::vector<std::thread> _workers;
+  std::queue<std::function<void()>> _tasks;
+  std::mutex _queueMutex;
+  std::condition_variable _condition;
+  bool _stop;
+
+public:
+  explicit LegacyThreadPool(size_t threadCount) : _stop(false) {
+    for (size_t i = 0; i < threadCount; ++i) {
+      _workers.emplace_back([this] {
+        while (true) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(_queueMutex);
+            _condition.wait(lock, [this] { return _stop || !_tasks.empty(); });
+            if (_stop && _tasks.empty()) {
+              return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  template <typename F> auto enqueue(F &&f) {
+    auto task = std::make_shared<std::packaged_task<void()>>(
+        std::forward<F>(f));
+    std::future<void> result = task->get_future();
+    {
+      std::unique_lock<std::mutex> lock(_queueMutex);
+      _tasks.emplace([task]() { (*task)(); });
+    }
+    _condition.notify_one();
+    return result;
+  }
+
+  void shutdown() {
+    {
+      std::unique_lock<std::mutex> lock(_queueMutex);
+      _stop = true;
+    }
+    _condition.notify_all();
+    for (std::thread &worker : _workers) {
+      worker.join();
+    }
+  }
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static void wait_for(const std::atomic<size_t> &counter, size_t target) {
+  while (counter.load(std::memory_order_acquire) < target) {
+    std::this_thread::yield();
+  }
+}
+
+// 外部线程提交count个只做计数的任务，返回每秒完成的任务数
+template <typename Pool>
+static double submit_throughput(Pool &pool, size_t count) {
+  std::atomic<size_t> done{0};
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    pool.enqueue([&done] { done.fetch_add(1, std::memory_order_release); });
+  }
+  wait_for(done, count);
+  return count / seconds_since(start);
+}
+
+// 外部线程只提交少量根任务，其余任务由工作线程递归派生
+template <typename Pool>
+static double fanout_throughput(Pool &pool, size_t count) {
+  const size_t roots = 64;
+  const size_t per_root = std::max<size_t>(count / roots, 1);
+  std::atomic<size_t> done{0};
+  std::function<void(size_t)> spawn = [&](size_t remaining) {
+    if (remaining > 1) {
+      size_t half = remaining / 2;
+      pool.enqueue([&spawn, half] { spawn(half); });
+      pool.enqueue([&spawn, remaining, half] { spawn(remaining - half); });
+    } else {
+      done.fetch_add(1, std::memory_order_release);
+    }
+  };
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < roots; ++i) {
+    pool.enqueue([&spawn, per_root] { spawn(per_root); });
+  }
+  wait_for(done, roots * per_root);
+  return roots * per_root / seconds_since(start);
+}
+
+struct Latency {
+  double p50;
+  double p99;
+};
+
+// 从enqueue到任务开始执行的间隔，逐个提交避免排队影响
+template <typename Pool>
+static Latency submit_latency(Pool &pool, size_t samples) {
+  std::vector<double> values;
+  values.reserve(samples);
+  std::atomic<int64_t> started{0};
+  for (size_t i = 0; i < samples; ++i) {
+    started.store(0, std::memory_order_relaxed);
+    auto submit = std::chrono::steady_clock::now();
+    pool.enqueue([&started] {
+      started.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                    std::memory_order_release);
+    });
+    int64_t at;
+    while ((at = started.load(std::memory_order_acquire)) == 0) {
+      std::this_thread::yield();
+    }
+    values.push_back(
+        std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::duration(at) - submit.time_since_epoch())
+            .count());
+  }
+  std::sort(values.begin(), values.end());
+  return Latency{values[values.size() / 2], values[values.size() * 99 / 100]};
+}
+
+struct Result {
+  double submit;
+  double fanout;
+  Latency latency;
+};
+
+template <typename Pool>
+static Result run(size_t threads, size_t count, size_t samples) {
+  Pool pool(threads);
+  Result result;
+  result.submit = submit_throughput(pool, count);
+  result.fanout = fanout_throughput(pool, count);
+  result.latency = submit_latency(pool, samples);
+  pool.shutdown();
+  return result;
+}
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  size_t samples = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+  size_t max_threads = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+  count = std::max<size_t>(count, 1);
+  samples = std::max<size_t>(samples, 1);
+
+  std::printf("每轮%zu个任务，%zu次延迟采样，%u个逻辑核心\n", count, samples,
+              std::thread::hardware_concurrency());
+  std::printf("吞吐单位：万任务/秒；延迟单位：us\n");
+  std::printf("%6s %-6s %12s %12s %10s %10s\n", "线程", "线程池",
+              "外部提交", "扇出", "p50", "p99");
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    Result legacy = run<LegacyThreadPool>(threads, count, samples);
+    Result stealing = run<ThreadPool>(threads, count, samples);
+    std::printf("%6zu %-6s %12.1f %12.1f %10.2f %10.2f\n", threads, "单队列",
+                legacy.submit / 1e4, legacy.fanout / 1e4, legacy.latency.p50,
+                legacy.latency.p99);
+    std::printf("%6s %-6s %12.1f %12.1f %10.2f %10.2f\n", "", "窃取",
+                stealing.submit / 1e4, stealing.fanout / 1e4,
+                stealing.latency.p50, stealing.latency.p99);
+  }
+  return 0;
+}
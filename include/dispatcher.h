@@ -2,10 +2,15 @@
 #include "memery_pool.h"
 #include "pthread_pool.h"
 #include "taskHander.h"
+#include "uring_file_table.h"
 #include "uring_types.h"
 #include <iostream>
 #include <liburing.h>
 #include <memory>
+#include <thread>
+
+// 分发专用配置
+#define DISPATCH_INLINE_ENABLED 1 // 1: 处理器判定不阻塞的请求直接在事件循环线程处理
 
 // 简洁的任务分发器
 class TaskDispatcher {
@@ -15,16 +20,202 @@ private:
   std::shared_ptr<MainThreadTaskQueue> _queue;
   std::shared_ptr<io_uring> _uring;
   std::shared_ptr<LayerMemoryPool> _memory_pool;
+  std::shared_ptr<UringFileTable> _file_table; // 可为空：不缓存文件描述符
+  bool _inline_enabled; // 不阻塞的请求是否在事件循环线程直接处理
+
+  // 处理器返回后请求视图已失效，此时才把额外缓冲区归还内存池
+  void release_extra_buffer(UringConnectionInfo *conn) {
+    if (conn->extra_buffer == nullptr || conn->extra_buffer_in_use) {
+      return;
+    }
+    if (_memory_pool) {
+      _memory_pool->deallocate_buffer(conn->extra_buffer);
+    }
+    conn->extra_buffer = nullptr;
+    conn->extra_buffer_filled = 0;
+  }
+
+  // 工作线程处理完请求：环和描述符缓存都只在事件循环线程访问，后续的
+  // 提交交回主线程队列，由入队唤醒事件循环；队列满时等事件循环腾出位置
+  void finish_pooled(UringConnectionInfo *processed_conn) {
+    if (!_queue) {
+      // 没有事件循环（不带主线程队列的用法），只能就地收尾
+      complete_pooled(processed_conn);
+      return;
+    }
+    while (!_queue->push_task(processed_conn,
+                              [this](UringConnectionInfo *conn) {
+                                complete_pooled(conn);
+                              })) {
+      if (!_queue->running()) {
+        std::cerr << "事件循环已停止，放弃提交，fd=" << processed_conn->fd
+                  << std::endl;
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // 事件循环线程上收尾线程池处理完的请求
+  void complete_pooled(UringConnectionInfo *processed_conn) {
+    release_extra_buffer(processed_conn);
+    std::cout << "线程池处理完成，fd=" << processed_conn->fd
+              << "，写缓冲区大小="
+              << processed_conn->write_buffer.get_readable_size() << std::endl;
+    if (_uring) {
+      submit_after_handle(processed_conn);
+    } else {
+      std::cout << "uring为空，无法设置写事件" << std::endl;
+    }
+  }
+
+  // 取sqe，提交队列满时先提交一次再取
+  static struct io_uring_sqe *acquire_sqe(io_uring *ring) {
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (!sqe) {
+      io_uring_submit(ring);
+      sqe = io_uring_get_sqe(ring);
+    }
+    return sqe;
+  }
+
+  // 后续事件提交失败时关闭连接，不让它停在没有任何事件的状态
+  void close_connection(UringConnectionInfo *conn) {
+    io_uring *ring = _uring.get();
+    struct io_uring_sqe *sqe = acquire_sqe(ring);
+    if (!sqe) {
+      std::cerr << "无法获取sqe，连接关闭提交失败，fd=" << conn->fd
+                << std::endl;
+      return;
+    }
+    conn->state = UringConnectionState::CLOSE;
+    io_uring_prep_close(sqe, conn->fd);
+    io_uring_sqe_set_data(sqe, conn);
+    io_uring_submit(ring);
+  }
+
+  // 处理器返回后在事件循环线程提交下一步：有响应先写出，请求在等文件打开时
+  // 开始打开文件，否则继续读；都提交不了时关闭连接
+  void submit_after_handle(UringConnectionInfo *conn) {
+    io_uring *ring = _uring.get();
+    release_file(conn);
+    if (conn->has_output()) {
+      size_t size = conn->pending_write_size();
+      if (!conn->prep_output(ring)) {
+        std::cerr << "无法获取sqe，写事件提交失败，关闭连接，fd=" << conn->fd
+                  << std::endl;
+        close_connection(conn);
+        return;
+      }
+      int submit_ret = io_uring_submit(ring);
+      std::cout << "立即提交写事件，fd=" << conn->fd << "，数据大小=" << size
+                << "字节，提交结果=" << submit_ret << std::endl;
+      return;
+    }
+
+    if (conn->file_op.state == UringFileOpState::REQUESTED) {
+      if (!start_file_open(conn)) {
+        std::cerr << "文件打开提交失败，关闭连接，fd=" << conn->fd
+                  << std::endl;
+        conn->file_op.reset();
+        close_connection(conn);
+      }
+      return;
+    }
+
+    // 写缓冲区为空，设置读事件继续处理
+    struct io_uring_sqe *sqe = acquire_sqe(ring);
+    if (!sqe) {
+      std::cerr << "无法获取sqe，读事件提交失败，关闭连接，fd=" << conn->fd
+                << std::endl;
+      close_connection(conn);
+      return;
+    }
+    conn->read_buffer.compact();
+    io_uring_prep_read(sqe, conn->fd, conn->read_buffer.get_write_tail(),
+                       conn->read_buffer.get_writable_size(), 0);
+    io_uring_sqe_set_data(sqe, conn);
+    conn->state = UringConnectionState::READ;
+    int submit_ret = io_uring_submit(ring);
+    std::cout << "写缓冲区为空，立即提交读事件，fd=" << conn->fd
+              << "，提交结果=" << submit_ret << std::endl;
+  }
 
 public:
   TaskDispatcher(std::shared_ptr<ThreadPool> pool = nullptr,
                  std::shared_ptr<MainThreadTaskQueue> queue = nullptr,
                  std::shared_ptr<io_uring> uring = nullptr,
-                 std::shared_ptr<LayerMemoryPool> memory_pool = nullptr)
-      : _pool(pool), _queue(queue), _uring(uring), _memory_pool(memory_pool){};
+                 std::shared_ptr<LayerMemoryPool> memory_pool = nullptr,
+                 std::shared_ptr<UringFileTable> file_table = nullptr)
+      : _pool(pool), _queue(queue), _uring(uring), _memory_pool(memory_pool),
+        _file_table(file_table), _inline_enabled(DISPATCH_INLINE_ENABLED){};
 
   ~TaskDispatcher() = default;
 
+  // 借用的文件描述符在文件流和流式响应都结束后归还缓存（只在事件循环线程调用）
+  void release_file(UringConnectionInfo *conn) {
+    if (_file_table && !conn->file_stream.active() &&
+        !conn->response_stream.active()) {
+      _file_table->release(conn);
+    }
+  }
+
+  // 开始打开等待中的文件：描述符缓存命中时直接继续，否则提交链接的
+  // OPENAT+STATX，完成后由事件循环继续（只在事件循环线程调用）
+  bool start_file_open(UringConnectionInfo *conn) {
+    release_file(conn);
+    if (_file_table && _file_table->lookup(conn)) {
+      return file_opened(conn);
+    }
+
+    // 两个sqe要么都拿到要么都不拿，不能留下半个带IO_LINK的链
+    io_uring *ring = _uring.get();
+    if (io_uring_sq_space_left(ring) < 2) {
+      io_uring_submit(ring);
+    }
+    if (io_uring_sq_space_left(ring) < 2) {
+      std::cerr << "无法获取sqe，文件打开提交失败，fd=" << conn->fd
+                << std::endl;
+      return false;
+    }
+    struct io_uring_sqe *open_sqe = io_uring_get_sqe(ring);
+    struct io_uring_sqe *stat_sqe = io_uring_get_sqe(ring);
+    conn->prep_file_open(open_sqe, stat_sqe);
+    return io_uring_submit(ring) >= 0;
+  }
+
+  // 文件已打开：要填充内容缓存的小文件先在环上整个读入，否则直接重新分发
+  // 请求（只在事件循环线程调用）
+  bool file_opened(UringConnectionInfo *conn) {
+    if (conn->file_op.wants_body() && conn->file_op.start_body()) {
+      return submit_file_body_read(conn);
+    }
+    return dispatch(conn);
+  }
+
+  // 读入文件内容的一次READ完成，读完后重新分发请求（只在事件循环线程调用）
+  bool file_body_read(UringConnectionInfo *conn, int result) {
+    if (!conn->file_op.finish_body_read(result)) {
+      return submit_file_body_read(conn);
+    }
+    return dispatch(conn);
+  }
+
+  bool submit_file_body_read(UringConnectionInfo *conn) {
+    struct io_uring_sqe *sqe = acquire_sqe(_uring.get());
+    if (!sqe) {
+      std::cerr << "无法获取sqe，文件读取提交失败，fd=" << conn->fd
+                << std::endl;
+      return false;
+    }
+    conn->prep_file_body_read(sqe);
+    return io_uring_submit(_uring.get()) >= 0;
+  }
+
+  // 关闭时所有完整请求都交给线程池（对比延迟用）
+  void set_inline_enabled(bool enabled) { _inline_enabled = enabled; }
+  bool inline_enabled() const { return _inline_enabled; }
+
   // 注册处理器实例
   void
   register_handler(std::unique_ptr<TaskHandler<UringConnectionInfo>> handler) {
@@ -39,113 +230,65 @@ public:
         std::cout << "可以处理" << std::endl;
         context->task_type = handler->get_name();
         if (handler->is_parse_complete(context)) {
-          context->parse_result = ParseResult::COMPLETE;
-          if (_pool) {
-            // 将任务提交到线程池，并设置回调
+          if (_pool && _uring && _inline_enabled &&
+              handler->can_run_inline(context)) {
+            // 不阻塞的请求在事件循环线程处理完直接提交写，省掉入队、
+            // 唤醒工作线程和跨线程回调
+            handler->handle_inline(context);
+            release_extra_buffer(context);
+            std::cout << "内联处理完成，fd=" << context->fd << std::endl;
+            submit_after_handle(context);
+          } else if (_pool) {
+            // 不需要结果，直接提交：只捕获三个指针，放在任务节点里不分配内存
+            // 工作线程只处理请求，之后的环操作由finish_pooled交回事件循环
             auto handler_ptr = handler.get();
-
-            // 定义回调函数：线程池完成任务后立即设置并提交写事件
-            auto callback = [this](UringConnectionInfo *processed_conn) {
-              std::cout << "线程池处理完成，fd=" << processed_conn->fd
-                        << "，写缓冲区大小="
-                        << processed_conn->write_buffer.get_readable_size()
-                        << std::endl;
-
-              // 立即设置并提交写事件，避免等待下一个事件循环
-              if (_uring) {
-                struct io_uring_sqe *sqe = io_uring_get_sqe(_uring.get());
-                if (sqe) {
-                  char *buffer = processed_conn->write_buffer.get_read_head();
-                  size_t size =
-                      processed_conn->write_buffer.get_readable_size();
-                  if (size > 0) {
-                    io_uring_prep_write(sqe, processed_conn->fd, buffer, size,
-                                        0);
-                    io_uring_sqe_set_data(sqe, processed_conn);
-                    processed_conn->state = UringConnectionState::WRITE;
-
-                    // 关键修复：立即提交io_uring事件
-                    int submit_ret = io_uring_submit(_uring.get());
-                    std::cout << "立即提交写事件，fd=" << processed_conn->fd
-                              << "，数据大小=" << size
-                              << "字节，提交结果=" << submit_ret << std::endl;
-
-                    // 打印响应内容的前100个字符用于调试
-                    std::string response_preview(buffer,
-                                                 std::min(size, size_t(100)));
-                    std::cout << "响应预览: " << response_preview << std::endl;
-                  } else {
-                    // 写缓冲区为空，设置读事件继续处理
-                    buffer = processed_conn->read_buffer.get_write_tail();
-                    size = processed_conn->read_buffer.get_writable_size();
-                    io_uring_prep_read(sqe, processed_conn->fd, buffer, size,
-                                       0);
-                    io_uring_sqe_set_data(sqe, processed_conn);
-                    processed_conn->state = UringConnectionState::READ;
-
-                    // 立即提交读事件
-                    int submit_ret = io_uring_submit(_uring.get());
-                    std::cout << "写缓冲区为空，立即提交读事件，fd="
-                              << processed_conn->fd
-                              << "，提交结果=" << submit_ret << std::endl;
-                  }
-                } else {
-                  std::cout << "无法获取sqe，尝试提交当前队列后重新获取"
-                            << std::endl;
-                  // 提交当前队列，然后重新获取sqe
-                  io_uring_submit(_uring.get());
-                  sqe = io_uring_get_sqe(_uring.get());
-                  if (sqe) {
-                    char *buffer = processed_conn->write_buffer.get_read_head();
-                    size_t size =
-                        processed_conn->write_buffer.get_readable_size();
-                    if (size > 0) {
-                      io_uring_prep_write(sqe, processed_conn->fd, buffer, size,
-                                          0);
-                      io_uring_sqe_set_data(sqe, processed_conn);
-                      processed_conn->state = UringConnectionState::WRITE;
-
-                      // 立即提交
-                      int submit_ret = io_uring_submit(_uring.get());
-                      std::cout << "重新获取sqe后立即提交写事件，fd="
-                                << processed_conn->fd
-                                << "，提交结果=" << submit_ret << std::endl;
-                    }
-                  }
-                }
-              } else {
-                std::cout << "uring为空，无法设置写事件" << std::endl;
-              }
-            };
-            // 使用带回调的任务提交，线程池完成函数后执行回调函数；
-            _pool->enqueue_with_callback(
-                [handler_ptr, context]() { handler_ptr->handle(context); },
-                context, callback);
+            _pool->post([this, handler_ptr, context]() {
+              handler_ptr->handle(context);
+              finish_pooled(context);
+            });
             std::cout << "线程(任务+回调任务)提交完成,(但是任务可能未完成)fd="
                       << context->fd << "--------------------------dispatcher"
                       << std::endl;
           } else {
             // 如果没有线程池，直接在当前线程处理
             handler->handle(context);
+            release_extra_buffer(context);
           }
           return true;
         }
         // 报文不完整，需要继续读取数据
         else {
+          // 头部都还没收全，直接在读缓冲区上继续读
+          if (context->bytes_NO_read == 0) {
+            return false;
+          }
           if (_queue && _uring) {
             // 创建读数据的任务
             bool ret = _queue->push_task(
                 context, [context, this](UringConnectionInfo *ctx) {
                   // 设置io_uring的读任务
                   ctx = context;
-                  struct io_uring_sqe *sqe = io_uring_get_sqe(_uring.get());
-                  if (sqe) {
+                  struct io_uring_sqe *sqe = acquire_sqe(_uring.get());
+                  if (!sqe) {
+                    std::cerr << "无法获取sqe，额外读事件提交失败，fd="
+                              << ctx->fd << std::endl;
+                  } else {
                     //从内存池获得空间
                     std::cout << "----dispatcher 报文不完整，需要继续读取数据"
                               << ctx->bytes_NO_read << std::endl;
                     ctx->extra_buffer =
                         _memory_pool->allocate_buffer(ctx->bytes_NO_read);
+                    if (ctx->extra_buffer == nullptr) {
+                      // 请求体超出内存池能力，无法接收，直接关闭连接
+                      std::cerr << "额外缓冲区分配失败，关闭连接，fd="
+                                << ctx->fd << std::endl;
+                      io_uring_prep_close(sqe, ctx->fd);
+                      io_uring_sqe_set_data(sqe, ctx);
+                      ctx->state = UringConnectionState::CLOSE;
+                      return;
+                    }
                     ctx->extra_buffer_in_use = true;
+                    ctx->extra_buffer_filled = 0;
                     io_uring_prep_read(sqe, ctx->fd, ctx->extra_buffer,
                                        ctx->bytes_NO_read, 0);
                     io_uring_sqe_set_data(sqe, ctx);
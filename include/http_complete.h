@@ -1,4 +1,10 @@
 #pragma once
+#include "http_range.h"
+#include "http_response.h"
+#include "http_router.h"
+#include "static_archive.h"
+#include "static_file_cache.h"
+#include "static_path_index.h"
 #include "uring_types.h"
 #include <algorithm>
 #include <atomic>
@@ -9,80 +15,251 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <memory_resource>
 #include <sstream>
+#include <string>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
 
-// HTTP请求结构体
+// HTTP流水线专用配置
+#define HTTP_PIPELINE_MAX_REQUESTS 64 // 一次读取后最多连续处理的请求数
+#define HTTP_PIPELINE_MIN_WRITE_SPACE (4 * 1024) // 写缓冲区低于此值时暂停
+
+// 路由的执行策略：分发器据此决定在事件循环线程直接处理还是交给线程池
+enum class HttpRoutePolicy : uint8_t {
+  INLINE,           // 只做内存操作，不阻塞
+  BLOCKING,         // 可能读文件或做其他阻塞操作
+  INLINE_IF_CACHED, // 静态文件：内容已在内存中（归档或缓存）时内联
+};
+
+// 分段只读视图：请求体可能前半段在读缓冲区、后半段在额外缓冲区，
+// 用两段string_view直接指向连接缓冲区，不拼接拷贝
+class SegmentedView {
+private:
+  std::string_view segments_[2];
+
+public:
+  SegmentedView() = default;
+  explicit SegmentedView(std::string_view first,
+                         std::string_view second = std::string_view()) {
+    // 保证非空数据总是从第一段开始
+    if (first.empty()) {
+      segments_[0] = second;
+    } else {
+      segments_[0] = first;
+      segments_[1] = second;
+    }
+  }
+
+  size_t size() const { return segments_[0].size() + segments_[1].size(); }
+  bool empty() const { return size() == 0; }
+  // 只有一段时可以直接当连续内存使用
+  bool is_contiguous() const { return segments_[1].empty(); }
+  std::string_view segment(size_t index) const { return segments_[index]; }
+
+  char operator[](size_t index) const {
+    return index < segments_[0].size()
+               ? segments_[0][index]
+               : segments_[1][index - segments_[0].size()];
+  }
+
+  // 拷贝[offset, offset+length)到out，返回实际拷贝的字节数
+  size_t copy_to(char *out, size_t offset, size_t length) const {
+    size_t copied = 0;
+    for (std::string_view segment : segments_) {
+      if (offset >= segment.size()) {
+        offset -= segment.size();
+        continue;
+      }
+      size_t n = std::min(length - copied, segment.size() - offset);
+      std::memcpy(out + copied, segment.data() + offset, n);
+      copied += n;
+      offset = 0;
+      if (copied == length) {
+        break;
+      }
+    }
+    return copied;
+  }
+};
+
+// 默认的chunked请求体接收端：只统计长度（现有路由不保存上传内容）
+class HttpCountingBodySink : public HttpBodySink {
+private:
+  size_t received_ = 0;
+  bool complete_ = false;
+
+public:
+  void on_data(std::string_view data) override { received_ += data.size(); }
+  void on_complete() override { complete_ = true; }
+  size_t received() const { return received_; }
+  bool complete() const { return complete_; }
+};
+
+// 遥测上报的接收端：请求体是换行分隔的记录，边到达边统计记录数和字节数，
+// 跨分块的半条记录只累计长度，不缓存内容
+class HttpTelemetrySink : public HttpBodySink {
+private:
+  size_t records_ = 0;
+  size_t bytes_ = 0;
+  size_t line_bytes_ = 0; // 还没遇到换行的当前记录长度
+  bool complete_ = false;
+
+  void end_record(size_t length) {
+    if (length > 0) {
+      ++records_;
+    }
+  }
+
+public:
+  void on_data(std::string_view data) override {
+    bytes_ += data.size();
+    while (!data.empty()) {
+      size_t newline = data.find('\n');
+      if (newline == std::string_view::npos) {
+        line_bytes_ += data.size();
+        return;
+      }
+      end_record(line_bytes_ + newline);
+      line_bytes_ = 0;
+      data.remove_prefix(newline + 1);
+    }
+  }
+  void on_complete() override {
+    // 最后一条记录可以没有换行
+    end_record(line_bytes_);
+    line_bytes_ = 0;
+    complete_ = true;
+  }
+  size_t records() const { return records_; }
+  size_t bytes() const { return bytes_; }
+  bool complete() const { return complete_; }
+};
+
+// HTTP请求结构体：所有字段都是指向连接缓冲区的视图，只在handle_message期间有效
 struct HttpRequest {
   std::string_view method;
   std::string_view url;
   std::string_view version;
-  std::unordered_map<std::string_view, std::string_view> headers;
-  std::string_view body;
-  size_t content_length;
+  HttpHeaderTable headers; // 内联头部表，常用头部按HttpHeaderId取值
+  SegmentedView body;     // chunked请求体已流式交付给接收端，这里为空
+  size_t content_length;  // 请求体长度（chunked时为解码后的总长度）
   bool is_chunked;
 
   HttpRequest() : content_length(0), is_chunked(false) {}
 };
 
-// HTTP响应结构体
-struct HttpResponse {
-  std::string response_line;
-  std::unordered_map<std::string, std::string> headers;
-  std::vector<char> body;
-
-  HttpResponse() {
-    response_line = "HTTP/1.1 200 OK\r\n";
-    headers["Content-Type"] = "text/html; charset=utf-8";
-    headers["Connection"] = "keep-alive";
-  }
-};
-
 class HttpTask {
-private:
-  // 解析状态
-  struct ParseState {
-    bool request_line_parsed;
-    bool headers_parsed;
-    bool body_parsed;
-    size_t body_bytes_received;
-
-    ParseState()
-        : request_line_parsed(false), headers_parsed(false), body_parsed(false),
-          body_bytes_received(0) {}
+public:
+  // 路由处理函数：params指向请求路径和路由表，只在本次处理期间有效
+  using RouteHandler = void (HttpTask::*)(UringConnectionInfo *info,
+                                          const HttpRouteParams &params);
+  // 在请求分配区中创建chunked请求体接收端
+  using BodySinkFactory = HttpBodySink *(*)(std::pmr::memory_resource *mr);
+  struct Route {
+    RouteHandler handler;
+    HttpRoutePolicy policy;
+    BodySinkFactory body_sink = nullptr; // 为空时只统计请求体长度
   };
 
+private:
+  std::pmr::memory_resource *mr_; // 请求分配区
   HttpRequest request_;
-  ParseState parse_state_;
   // 打印请求
   // void printf_request();
-  // 解析请求行
-  bool parse_request_line(std::string_view data);
+  // 根据连接解析器记录的区间填充请求
+  // base为报文起点，available为读缓冲区中该报文的字节数，
+  // overflow为额外缓冲区中请求体的后半段
+  void populate_request(const HttpParser &parser, const char *base,
+                        size_t available, std::string_view overflow);
 
-  // 解析请求头
-  bool parse_request_headers(std::string_view data);
+  // 请求是否允许保持连接：HTTP/1.1默认保持，HTTP/1.0默认关闭，
+  // 都以Connection头部中的close/keep-alive为准
+  static bool request_keeps_alive(const HttpRequest &request);
 
-  // 解析请求体
-  bool parse_request_body(std::string_view data);
+  // 发送简单响应：直接序列化到写缓冲区，Connection头部由连接状态决定
+  bool send_simple_response(UringConnectionInfo *info, HttpResponse &response);
 
-  // 发送简单响应
-  void send_simple_response(UringConnectionInfo *info,
-                            const HttpResponse &response);
+  // 发送流式响应：先写响应头，响应体由producer按写缓冲区空间逐段拉取
+  // producer须位于连接的请求分配区，响应结束或失败时由连接负责销毁
+  bool send_stream_response(UringConnectionInfo *info, HttpResponse &response,
+                            HttpBodyProducer *producer);
 
-  // 发送文件响应（零拷贝）
+  // 发送文件响应（文件内容分段流式读入写缓冲区）
   void send_file_response(UringConnectionInfo *info,
-                          const std::string &file_path);
+                          const std::pmr::string &file_path);
+
+  // 发送缓存的文件响应：小文件拷进写缓冲区，大文件直接从缓存条目写出
+  // Entry为StaticCacheEntry或StaticArchiveFile，Variant为对应的编码表示
+  template <typename Entry, typename Variant>
+  void send_cached_response(UringConnectionInfo *info,
+                            const std::shared_ptr<const Entry> &entry,
+                            const Variant &variant);
+
+  // 按Accept-Encoding的q值选择条目已有的编码，范围请求总是用原始内容
+  template <typename Entry>
+  ContentEncoding choose_encoding(const Entry &entry) const;
+
+  // 条件请求：If-None-Match优先，没有时才看If-Modified-Since
+  // 返回true表示客户端缓存仍然有效，应回复304
+  bool is_not_modified(std::string_view etag, time_t last_modified) const;
+
+  // 发送304：只带ETag和Last-Modified，没有响应体
+  bool send_not_modified(UringConnectionInfo *info,
+                         std::string_view validators);
 
-  // 处理简单任务
+  // 静态文件不存在时的404
+  bool send_not_found(UringConnectionInfo *info);
+
+  // 按Range头部发送206或416；没有Range、If-Range不匹配或Range无效时
+  // 返回false，由调用方发送完整响应。返回true时source.fd已交出或关闭
+  bool send_range_response(UringConnectionInfo *info, HttpRangeSource &source);
+
+  // 内存中的静态文件：304、Range或完整响应
+  template <typename Entry>
+  void send_static_entry(UringConnectionInfo *info,
+                         const std::shared_ptr<const Entry> &entry);
+
+  // 发送静态文件：归档模式只查归档；否则优先走缓存，不可缓存时直接读文件
+  // 由事件循环驱动时未命中的文件在环上打开和读入，用读到的内容填充缓存
+  void send_static_file(UringConnectionInfo *info, std::string_view path);
+
+  // 注册全部路由，新接口在这里添加
+  static HttpRouter<Route> build_routes();
+
+  // 按连接里已解析的请求行查路由（头部解析完即可调用），没有匹配时返回nullptr
+  static const Route *find_route(UringConnectionInfo *info);
+
+  // 静态文件请求不用读文件就能回复（归档、新鲜的缓存条目或一定不存在）
+  static bool is_static_in_memory(UringConnectionInfo *info,
+                                  std::string_view url);
+
+  // 路由处理函数
+  void handle_root(UringConnectionInfo *info, const HttpRouteParams &params);
+  void handle_health(UringConnectionInfo *info, const HttpRouteParams &params);
+  void handle_static(UringConnectionInfo *info, const HttpRouteParams &params);
+  void handle_post(UringConnectionInfo *info, const HttpRouteParams &params);
+  void handle_telemetry(UringConnectionInfo *info,
+                        const HttpRouteParams &params);
+
+  // 按方法和路径查路由表分发，没有匹配时回复404或405
   void handle_task(UringConnectionInfo *info);
 
 public:
-  HttpTask() = default;
+  explicit HttpTask(
+      std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+      : mr_(mr) {}
   // 主处理函数：流式解析和处理HTTP请求
   bool handle_message(UringConnectionInfo *info);
 
+  // 路由表：首次调用时构建（main在启动时调用一次），之后只读
+  static const HttpRouter<Route> &routes();
+
+  // 已解析完整的请求能否在事件循环线程直接处理：按路由的执行策略判断，
+  // 错误响应、404/405总是内联；文件已在环上打开的请求重新处理时交给线程池
+  static bool can_run_inline(UringConnectionInfo *info);
+
   // 静态方法：判断是否为HTTP任务
   static bool is_http_task(UringConnectionInfo *info);
 
@@ -90,4 +267,12 @@ public:
   static bool is_http_parse_complete(UringConnectionInfo *info);
   // 判断报文是否完整
   static ParseResult is_complete_message(UringConnectionInfo *info);
+
+  // 为chunked请求体创建接收端（在连接的请求分配区中）：头部解析完时按路由
+  // 选择，路由没有指定时只统计长度
+  static HttpBodySink *open_body_sink(UringConnectionInfo *info);
+
+  // 流水线：读缓冲区里还有下一个可以立即处理的请求（完整或需要报错）时返回true
+  // 写缓冲区剩余空间不足时返回false，等写出后由事件循环继续
+  static bool has_pipelined_request(UringConnectionInfo *info);
 };
\ No newline at end of file
@@ -0,0 +1,183 @@
+#pragma once
+// C++标准库头文件
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 服务器关心的常用请求头，解析时识别一次，之后按下标直接取值
+enum class HttpHeaderId : uint8_t {
+  HOST,
+  CONTENT_LENGTH,
+  CONNECTION,
+  TRANSFER_ENCODING,
+  IF_NONE_MATCH,
+  IF_MODIFIED_SINCE,
+  RANGE,
+  IF_RANGE,
+  ACCEPT_ENCODING,
+  UNKNOWN, // 其它头部
+};
+
+#define HTTP_MAX_HEADERS 64 // 单个请求最多头部行数
+#define HTTP_KNOWN_HEADER_COUNT (static_cast<size_t>(HttpHeaderId::UNKNOWN))
+#define HTTP_HEADER_HASH_SIZE 16 // 完美哈希表大小（2的幂）
+
+// 小写形式的标准头部名，下标与HttpHeaderId一致
+constexpr std::string_view kKnownHeaderNames[HTTP_KNOWN_HEADER_COUNT] = {
+    "host",
+    "content-length",
+    "connection",
+    "transfer-encoding",
+    "if-none-match",
+    "if-modified-since",
+    "range",
+    "if-range",
+    "accept-encoding",
+};
+
+constexpr char http_to_lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// 大小写不敏感比较，lower必须是小写
+constexpr bool http_iequals(std::string_view data, std::string_view lower) {
+  if (data.size() != lower.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (http_to_lower(data[i]) != lower[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 哈希只看长度、首字符、尾字符，参数对上面的名字集合无冲突（见static_assert）
+constexpr size_t http_header_hash(std::string_view name) {
+  size_t first = static_cast<unsigned char>(http_to_lower(name.front()));
+  size_t last = static_cast<unsigned char>(http_to_lower(name.back()));
+  return (name.size() + first + last * 7) & (HTTP_HEADER_HASH_SIZE - 1);
+}
+
+// 编译期生成的哈希槽 -> HttpHeaderId表
+struct HttpHeaderHashTable {
+  HttpHeaderId slots[HTTP_HEADER_HASH_SIZE] = {};
+  bool perfect = true; // 是否无冲突
+
+  constexpr HttpHeaderHashTable() {
+    for (size_t i = 0; i < HTTP_HEADER_HASH_SIZE; ++i) {
+      slots[i] = HttpHeaderId::UNKNOWN;
+    }
+    for (size_t id = 0; id < HTTP_KNOWN_HEADER_COUNT; ++id) {
+      size_t slot = http_header_hash(kKnownHeaderNames[id]);
+      if (slots[slot] != HttpHeaderId::UNKNOWN) {
+        perfect = false;
+      }
+      slots[slot] = static_cast<HttpHeaderId>(id);
+    }
+  }
+};
+constexpr HttpHeaderHashTable kHeaderHashTable;
+static_assert(kHeaderHashTable.perfect, "常用头部的哈希存在冲突，需要调整参数");
+
+// 头部名 -> HttpHeaderId：一次哈希定位候选，再做一次比较确认
+constexpr HttpHeaderId http_header_id(std::string_view name) {
+  if (name.empty()) {
+    return HttpHeaderId::UNKNOWN;
+  }
+  HttpHeaderId id = kHeaderHashTable.slots[http_header_hash(name)];
+  if (id != HttpHeaderId::UNKNOWN &&
+      http_iequals(name, kKnownHeaderNames[static_cast<size_t>(id)])) {
+    return id;
+  }
+  return HttpHeaderId::UNKNOWN;
+}
+
+// 一个请求头：名字与值都指向连接缓冲区
+struct HttpHeaderEntry {
+  std::string_view name;
+  std::string_view value;
+  HttpHeaderId id;
+};
+
+// 扁平请求头表：按到达顺序存放在内联数组里，不做任何堆分配
+// 常用头部额外记录下标，按HttpHeaderId查询是O(1)
+class HttpHeaderTable {
+private:
+  static constexpr uint8_t kNoIndex = 0xff;
+  static_assert(HTTP_MAX_HEADERS < kNoIndex, "头部下标需要放进uint8_t");
+
+  std::array<HttpHeaderEntry, HTTP_MAX_HEADERS> entries_;
+  std::array<uint8_t, HTTP_KNOWN_HEADER_COUNT> known_;
+  size_t count_;
+
+public:
+  HttpHeaderTable() { clear(); }
+
+  void clear() {
+    known_.fill(kNoIndex);
+    count_ = 0;
+  }
+
+  // 追加一个头部，表满返回false；同名常用头部以第一次出现为准
+  bool add(HttpHeaderId id, std::string_view name, std::string_view value) {
+    if (count_ >= entries_.size()) {
+      return false;
+    }
+    if (id != HttpHeaderId::UNKNOWN &&
+        known_[static_cast<size_t>(id)] == kNoIndex) {
+      known_[static_cast<size_t>(id)] = static_cast<uint8_t>(count_);
+    }
+    entries_[count_++] = HttpHeaderEntry{name, value, id};
+    return true;
+  }
+
+  bool add(std::string_view name, std::string_view value) {
+    return add(http_header_id(name), name, value);
+  }
+
+  bool contains(HttpHeaderId id) const {
+    return id != HttpHeaderId::UNKNOWN &&
+           known_[static_cast<size_t>(id)] != kNoIndex;
+  }
+
+  // 常用头部：直接按下标取值，不存在返回空
+  std::string_view get(HttpHeaderId id) const {
+    if (!contains(id)) {
+      return std::string_view();
+    }
+    return entries_[known_[static_cast<size_t>(id)]].value;
+  }
+
+  // 任意头部（大小写不敏感），常用头部走下标，其它顺序查找
+  std::string_view find(std::string_view name) const {
+    HttpHeaderId id = http_header_id(name);
+    if (id != HttpHeaderId::UNKNOWN) {
+      return get(id);
+    }
+    for (size_t i = 0; i < count_; ++i) {
+      const HttpHeaderEntry &entry = entries_[i];
+      if (entry.name.size() != name.size()) {
+        continue;
+      }
+      size_t j = 0;
+      while (j < name.size() &&
+             http_to_lower(entry.name[j]) == http_to_lower(name[j])) {
+        ++j;
+      }
+      if (j == name.size()) {
+        return entry.value;
+      }
+    }
+    return std::string_view();
+  }
+
+  size_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  const HttpHeaderEntry &operator[](size_t index) const {
+    return entries_[index];
+  }
+  const HttpHeaderEntry *begin() const { return entries_.data(); }
+  const HttpHeaderEntry *end() const { return entries_.data() + count_; }
+};
@@ -0,0 +1,160 @@
+#pragma once
+// C++标准库头文件
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 项目头文件
+#include "http_headers.h"
+
+// HTTP解析模块专用配置
+#define HTTP_MAX_HEADER_BYTES (16 * 1024) // 请求行+头部最大字节数
+#define HTTP_MAX_BODY_SIZE (512 * 1024)   // Content-Length请求体上限（整体缓存）
+#define HTTP_MAX_STREAM_BODY_SIZE (64UL * 1024 * 1024) // chunked请求体上限
+
+// http报文解析枚举状态
+enum class ParseResult {
+  COMPLETE,
+  NEEED_MORE_DATA,
+  INVALID_FORMAT,
+  PAYLOAD_TOO_LARGE,
+};
+
+// chunked请求体接收端：解码出的数据边到达边交付，不整体缓存
+class HttpBodySink {
+public:
+  virtual ~HttpBodySink() = default;
+  // 一段解码后的请求体，视图只在调用期间有效
+  virtual void on_data(std::string_view data) = 0;
+  // 请求体结束（收到最后一个0长度分块）
+  virtual void on_complete() {}
+};
+
+// 报文中的一段区间，记录相对报文起点的偏移（不拷贝数据）
+struct HttpSpan {
+  uint32_t offset = 0;
+  uint32_t length = 0;
+
+  std::string_view view(const char *base) const {
+    return std::string_view(base + offset, length);
+  }
+};
+
+// 一个请求头的名字与值区间，常用头部在解析时就识别出id
+struct HttpHeaderSpan {
+  HttpSpan name;
+  HttpSpan value;
+  HttpHeaderId id;
+};
+
+// 增量HTTP/1.1请求解析器（状态机）
+// 状态与扫描位置保存在连接里，每次读完只从上次停下的位置继续扫描新字节，
+// 每个字节只处理一次；解析结果是相对报文起点的区间，不拷贝数据
+class HttpParser {
+public:
+  enum class State : uint8_t {
+    METHOD,             // 请求方法
+    URL,                // 请求目标
+    VERSION,            // 协议版本
+    REQUEST_LINE_LF,    // 请求行的\n
+    HEADER_LINE_START,  // 头部行开始（或空行）
+    HEADER_NAME,        // 头部名
+    HEADER_VALUE_START, // 冒号后的空白
+    HEADER_VALUE,       // 头部值
+    HEADER_LINE_LF,     // 头部行的\n
+    HEADERS_END_LF,     // 空行的\n
+    BODY,               // 按Content-Length等待请求体，或解码chunked请求体
+    DONE,               // 一个完整请求
+    ERROR,              // 格式错误
+    TOO_LARGE           // 请求体超过上限
+  };
+
+  // chunked请求体的子状态
+  enum class ChunkState : uint8_t {
+    SIZE,        // 十六进制分块长度
+    EXTENSION,   // 分块扩展（;之后，忽略）
+    SIZE_LF,     // 长度行的\n
+    DATA,        // 分块数据
+    DATA_CR,     // 数据后的\r
+    DATA_LF,     // 数据后的\n
+    TRAILER,     // trailer行开始（或结束空行）
+    TRAILER_LINE, // trailer行内容（忽略）
+    END_LF       // 结束空行的\n
+  };
+
+private:
+  State state_;
+  size_t pos_;          // 下一个待扫描字节（相对报文起点）
+  size_t token_start_;  // 当前记号起点
+  size_t value_end_;    // 当前头部值去掉尾部空白后的终点
+  size_t header_end_;   // 头部结束位置（即请求体起点）
+  HttpSpan method_;
+  HttpSpan url_;
+  HttpSpan version_;
+  HttpSpan current_name_;
+  HttpHeaderSpan headers_[HTTP_MAX_HEADERS];
+  size_t header_count_;
+  size_t content_length_;
+  bool chunked_;                // 最后一个传输编码是chunked
+  bool has_content_length_;     // 已出现Content-Length
+  bool has_transfer_encoding_;  // 已出现Transfer-Encoding
+  ChunkState chunk_state_;
+  size_t chunk_remaining_; // 当前分块还未交付的字节数
+  size_t chunk_digits_;    // 当前长度行已读的十六进制位数
+  size_t chunk_line_bytes_; // 当前扩展或trailer行的长度
+  size_t body_length_;     // 已解码交付的请求体总长度
+
+  // 一个头部行结束：记录区间、识别头部id，处理Content-Length/Transfer-Encoding
+  // 重复或冲突的报文长度头部返回false（按400处理并关闭连接）
+  bool finish_header(const char *base);
+  // 解析Transfer-Encoding的编码列表，chunked之后还有编码时返回false
+  bool parse_transfer_codings(std::string_view text);
+  void finish_headers();
+  // 从pos_继续解码chunked请求体，数据段直接交付给sink
+  ParseResult execute_chunked(const char *base, size_t size,
+                              HttpBodySink *sink);
+
+public:
+  HttpParser() { reset(); }
+
+  // 为下一个请求复位
+  void reset();
+
+  // 从上次停下的位置继续解析；base是报文起点，size是当前可用的总字节数
+  // chunked请求体需要接收端：sink为空时停在请求体起点，等调用方准备好再继续
+  ParseResult execute(const char *base, size_t size,
+                      HttpBodySink *sink = nullptr);
+
+  // chunked：已解码交付的原始字节（头部之后到pos_）不再需要，返回其长度，
+  // 调用方从缓冲区中移除[body_offset(), body_offset()+返回值)
+  size_t release_chunked_input();
+
+  State state() const { return state_; }
+  bool headers_complete() const {
+    return state_ == State::BODY || state_ == State::DONE;
+  }
+
+  std::string_view method(const char *base) const {
+    return method_.view(base);
+  }
+  std::string_view url(const char *base) const { return url_.view(base); }
+  std::string_view version(const char *base) const {
+    return version_.view(base);
+  }
+  size_t header_count() const { return header_count_; }
+  const HttpHeaderSpan &header(size_t index) const { return headers_[index]; }
+
+  size_t content_length() const { return content_length_; }
+  bool is_chunked() const { return chunked_; }
+  // 请求体长度：chunked时为已解码的总长度
+  size_t body_length() const {
+    return chunked_ ? body_length_ : content_length_;
+  }
+  // 请求体起点（头部之后）
+  size_t body_offset() const { return header_end_; }
+  // 缓冲区中整个请求报文长度（头部+请求体），头部解析完才有意义
+  // chunked时为头部加上尚未移除的原始请求体字节
+  size_t message_length() const {
+    return chunked_ ? pos_ : header_end_ + content_length_;
+  }
+};
@@ -0,0 +1,122 @@
+#pragma once
+// C++标准库头文件
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string_view>
+
+// 项目头文件
+#include "http_response.h"
+#include "http_stream.h"
+
+// Range请求专用配置
+#define HTTP_MAX_RANGES 8 // 单个请求最多的范围数，超过时忽略Range返回完整内容
+#define HTTP_RANGE_PART_HEADER_SIZE 256 // multipart每段头部的缓冲区大小
+
+// 多段范围响应的Content-Type，分隔符取其中boundary=之后的部分
+constexpr std::string_view kByterangesContentType =
+    "multipart/byteranges; boundary=5f3c9a1e7b2d4068";
+constexpr std::string_view kByterangesBoundary =
+    kByterangesContentType.substr(31);
+
+// Content-Range值的最大长度："bytes "、三个最多20位的数和"-"、"/"
+constexpr size_t kContentRangeMaxSize = 6 + 3 * 20 + 2;
+
+// 闭区间[first, last]
+struct HttpByteRange {
+  size_t first;
+  size_t last;
+
+  size_t length() const { return last - first + 1; }
+};
+
+enum class HttpRangeResult : uint8_t {
+  NONE,          // 语法错误或范围太多，按没有Range处理
+  SATISFIABLE,   // 至少一段范围落在文件内
+  UNSATISFIABLE, // 所有范围都在文件之外，应回复416
+};
+
+// 解析"bytes=a-b, c-, -n"，按文件大小求出实际范围（保持请求中的顺序）
+HttpRangeResult http_parse_ranges(std::string_view header, size_t size,
+                                  HttpByteRange *ranges, size_t &count);
+
+// 范围响应的数据来源：文件描述符（按偏移pread）或缓存中的文件内容
+struct HttpRangeSource {
+  HttpMime mime;
+  size_t size;
+  std::string_view etag;
+  time_t last_modified;
+  int fd; // >=0时从文件读，交给响应体后由它关闭
+  bool borrowed; // fd借自描述符缓存，响应体只读不关
+  std::string_view data;             // fd<0时使用的文件内容
+  std::shared_ptr<const void> owner; // data的所有者（缓存条目）
+
+  HttpRangeSource()
+      : mime(HttpMime::OCTET_STREAM), size(0), last_modified(0), fd(-1),
+        borrowed(false) {}
+};
+
+// 多段范围响应体：按顺序输出每段的分隔头部和数据，最后是结束分隔符
+// 单段时只输出数据；文件数据按偏移直接读入写缓冲区，不整体载入内存
+// 数据源是文件时会pread，只用于不由事件循环驱动的连接（见HttpBodyProducer）
+class HttpRangeBodyProducer : public HttpBodyProducer {
+private:
+  HttpRangeSource source_;
+  HttpByteRange ranges_[HTTP_MAX_RANGES];
+  size_t count_;
+  size_t index_;     // 当前段
+  size_t offset_;    // 当前段已输出的数据字节数
+  bool multipart_;
+  char header_[HTTP_RANGE_PART_HEADER_SIZE]; // 当前段的分隔头部
+  size_t header_size_;
+  size_t header_pos_;
+
+  // 准备下一段的分隔头部（最后一段之后是结束分隔符）
+  void prepare_header();
+
+public:
+  HttpRangeBodyProducer(HttpRangeSource source, const HttpByteRange *ranges,
+                        size_t count);
+  ~HttpRangeBodyProducer() override;
+
+  size_t produce(char *out, size_t capacity, bool &finished) override;
+
+  // 响应体总长度（Content-Length）
+  static size_t body_length(const HttpRangeSource &source,
+                            const HttpByteRange *ranges, size_t count);
+};
+
+// 在环上按偏移读文件的多段范围响应：这里只生成每段数据之前的分隔头部
+// 和最后的结束分隔符，段数据由调用方读入，不在事件循环线程读文件
+class HttpRangeParts {
+private:
+  HttpMime mime_;
+  size_t size_;
+  HttpByteRange ranges_[HTTP_MAX_RANGES];
+  size_t count_;
+  size_t index_; // 下一个要生成头部的段，等于count_时该生成结束分隔符
+
+public:
+  HttpRangeParts()
+      : mime_(HttpMime::OCTET_STREAM), size_(0), count_(0), index_(0) {}
+
+  void start(HttpMime mime, size_t size, const HttpByteRange *ranges,
+             size_t count);
+  void clear() {
+    count_ = 0;
+    index_ = 0;
+  }
+
+  // 分隔头部都已生成（不是多段响应时始终为true）
+  bool done() const { return count_ == 0 || index_ > count_; }
+
+  // 把下一段的分隔头部（最后一段之后是结束分隔符）写入out，out至少
+  // HTTP_RANGE_PART_HEADER_SIZE字节，written返回写入的字节数；
+  // 后面跟着数据段时返回true并由range给出
+  bool next(char *out, size_t &written, HttpByteRange &range);
+};
+
+// "bytes a-b/size"，返回写入的字节数（out至少kContentRangeMaxSize字节）
+size_t http_format_content_range(char *out, const HttpByteRange &range,
+                                 size_t size);
@@ -0,0 +1,207 @@
+#pragma once
+// C++标准库头文件
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+#include <utility>
+
+// 项目头文件
+#include "http_stream.h"
+
+// HTTP响应模块专用配置
+#define HTTP_RESPONSE_MAX_EXTRA_HEADERS 8 // 单个响应最多附加头部数
+#define HTTP_DATE_SLOTS 8 // Date缓存槽数，读者最多容忍这么多次刷新
+
+// 响应状态码
+enum class HttpStatus : uint16_t {
+  OK = 200,
+  PARTIAL_CONTENT = 206,
+  NOT_MODIFIED = 304,
+  BAD_REQUEST = 400,
+  NOT_FOUND = 404,
+  METHOD_NOT_ALLOWED = 405,
+  PAYLOAD_TOO_LARGE = 413,
+  RANGE_NOT_SATISFIABLE = 416,
+  INTERNAL_SERVER_ERROR = 500,
+  NOT_IMPLEMENTED = 501,
+  SERVICE_UNAVAILABLE = 503,
+};
+
+// 完整状态行（含\r\n），编译期常量
+constexpr std::string_view http_status_line(HttpStatus status) {
+  switch (status) {
+  case HttpStatus::OK:
+    return "HTTP/1.1 200 OK\r\n";
+  case HttpStatus::PARTIAL_CONTENT:
+    return "HTTP/1.1 206 Partial Content\r\n";
+  case HttpStatus::NOT_MODIFIED:
+    return "HTTP/1.1 304 Not Modified\r\n";
+  case HttpStatus::BAD_REQUEST:
+    return "HTTP/1.1 400 Bad Request\r\n";
+  case HttpStatus::NOT_FOUND:
+    return "HTTP/1.1 404 Not Found\r\n";
+  case HttpStatus::METHOD_NOT_ALLOWED:
+    return "HTTP/1.1 405 Method Not Allowed\r\n";
+  case HttpStatus::PAYLOAD_TOO_LARGE:
+    return "HTTP/1.1 413 Payload Too Large\r\n";
+  case HttpStatus::RANGE_NOT_SATISFIABLE:
+    return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+  case HttpStatus::NOT_IMPLEMENTED:
+    return "HTTP/1.1 501 Not Implemented\r\n";
+  case HttpStatus::SERVICE_UNAVAILABLE:
+    return "HTTP/1.1 503 Service Unavailable\r\n";
+  default:
+    return "HTTP/1.1 500 Internal Server Error\r\n";
+  }
+}
+
+// 响应内容类型
+enum class HttpMime : uint8_t {
+  NONE, // 不输出Content-Type
+  HTML,
+  PLAIN,
+  CSS,
+  JAVASCRIPT,
+  PNG,
+  JPEG,
+  OCTET_STREAM,
+};
+
+// 完整的Content-Type头部行，编译期常量
+constexpr std::string_view http_content_type_line(HttpMime mime) {
+  switch (mime) {
+  case HttpMime::HTML:
+    return "Content-Type: text/html; charset=utf-8\r\n";
+  case HttpMime::PLAIN:
+    return "Content-Type: text/plain; charset=utf-8\r\n";
+  case HttpMime::CSS:
+    return "Content-Type: text/css; charset=utf-8\r\n";
+  case HttpMime::JAVASCRIPT:
+    return "Content-Type: application/javascript\r\n";
+  case HttpMime::PNG:
+    return "Content-Type: image/png\r\n";
+  case HttpMime::JPEG:
+    return "Content-Type: image/jpeg\r\n";
+  case HttpMime::OCTET_STREAM:
+    return "Content-Type: application/octet-stream\r\n";
+  default:
+    return "";
+  }
+}
+
+// 按文件扩展名推断内容类型
+HttpMime http_mime_from_path(std::string_view path);
+
+constexpr std::string_view kConnectionKeepAliveLine =
+    "Connection: keep-alive\r\n";
+constexpr std::string_view kConnectionCloseLine = "Connection: close\r\n";
+constexpr std::string_view kContentLengthPrefix = "Content-Length: ";
+constexpr std::string_view kChunkedEncodingLine =
+    "Transfer-Encoding: chunked\r\n";
+constexpr size_t kHttpDateSize = 29; // IMF-fixdate: "Sun, 06 Nov 1994 08:49:37 GMT"
+constexpr size_t kDateLineSize = 37; // "Date: " + IMF-fixdate(29) + "\r\n"
+
+// 格式化IMF-fixdate，写入kHttpDateSize字节
+void http_format_date(char *out, time_t time);
+// 解析IMF-fixdate（If-Modified-Since），其他格式返回false
+bool http_parse_date(std::string_view text, time_t &time);
+
+// ETag和Last-Modified头部行的长度上限（ETag不超过64字节）
+constexpr size_t kValidatorsMaxSize = 64 + 6 + 2 + 15 + kHttpDateSize + 2;
+// 写出"ETag: ...\r\nLast-Modified: ...\r\n"，返回写入的字节数
+size_t http_format_validators(char *out, std::string_view etag,
+                              time_t last_modified);
+
+// Date头部缓存：事件循环每秒刷新一次，工作线程只做一次拷贝
+// 多槽轮换发布，读者拿到的槽在之后HTTP_DATE_SLOTS次刷新内都不会被覆盖
+class HttpDateCache {
+private:
+  struct Slot {
+    char line[kDateLineSize];
+  };
+  std::array<Slot, HTTP_DATE_SLOTS> slots_;
+  std::atomic<size_t> current_;
+  std::atomic<time_t> second_;
+
+  HttpDateCache();
+
+public:
+  static HttpDateCache &instance();
+
+  // 秒数变化时重新格式化，否则立即返回（可以每轮事件循环调用）
+  void update(time_t now);
+
+  // 当前完整的Date头部行（含\r\n）
+  std::string_view line() const {
+    const Slot &slot = slots_[current_.load(std::memory_order_acquire)];
+    return std::string_view(slot.line, kDateLineSize);
+  }
+};
+
+// 响应描述：状态、内容类型和附加头部都是视图或枚举，不做堆分配
+// body必须在写出前保持有效（字面量或请求分配区内存）
+struct HttpResponse {
+  HttpStatus status;
+  HttpMime content_type;
+  bool keep_alive;
+  HttpBodyFraming framing; // 流式响应长度未知时为CHUNKED或UNTIL_CLOSE
+  std::string_view body;
+  size_t content_length; // 默认等于body大小，文件响应时单独设置
+  // 预先格式化好的实体头部行（缓存条目），非空时代替Content-Type和Content-Length
+  std::string_view preformatted;
+  std::array<std::pair<std::string_view, std::string_view>,
+             HTTP_RESPONSE_MAX_EXTRA_HEADERS>
+      extra_headers;
+  size_t extra_count;
+
+  HttpResponse()
+      : status(HttpStatus::OK), content_type(HttpMime::HTML), keep_alive(true),
+        framing(HttpBodyFraming::CONTENT_LENGTH), content_length(0),
+        extra_count(0) {}
+
+  // 设置响应体，同时设置Content-Length
+  void set_body(std::string_view text) {
+    body = text;
+    content_length = text.size();
+  }
+
+  void set_content_length(size_t length) { content_length = length; }
+
+  // 附加一个头部，超过上限返回false
+  bool add_header(std::string_view name, std::string_view value) {
+    if (extra_count >= extra_headers.size()) {
+      return false;
+    }
+    extra_headers[extra_count++] = {name, value};
+    return true;
+  }
+};
+
+// 就地序列化：直接写到输出缓冲区，空间不足时停止写入并标记失败
+class HttpResponseWriter {
+private:
+  char *out_;
+  size_t capacity_;
+  size_t size_;
+  bool overflow_;
+
+  void append(std::string_view piece);
+
+public:
+  HttpResponseWriter(char *out, size_t capacity)
+      : out_(out), capacity_(capacity), size_(0), overflow_(false) {}
+
+  // 序列化后的响应头长度（状态行+头部+空行），用于预先检查空间
+  static size_t header_size(const HttpResponse &response);
+
+  // 写出状态行、头部和空行
+  void write_headers(const HttpResponse &response);
+  // 写出响应体
+  void write_body(std::string_view body) { append(body); }
+
+  bool ok() const { return !overflow_; }
+  size_t size() const { return size_; }
+};
@@ -0,0 +1,152 @@
+#pragma once
+// C++标准库头文件
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 路由专用配置
+#define HTTP_ROUTE_MAX_PARAMS 8 // 单条路由最多的参数个数（含通配）
+#define HTTP_ALLOW_LINE_SIZE 64 // Allow头部值的缓冲区大小
+
+// 路由认识的请求方法，其他方法按UNKNOWN处理（总是405）
+enum class HttpMethod : uint8_t {
+  GET,
+  HEAD,
+  POST,
+  PUT,
+  DELETE,
+  OPTIONS,
+  PATCH,
+  UNKNOWN,
+};
+
+#define HTTP_METHOD_COUNT (static_cast<size_t>(HttpMethod::UNKNOWN))
+
+constexpr std::string_view kHttpMethodNames[HTTP_METHOD_COUNT] = {
+    "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH",
+};
+
+// 方法名区分大小写（RFC 9110）
+constexpr HttpMethod http_method_from(std::string_view name) {
+  for (size_t i = 0; i < HTTP_METHOD_COUNT; ++i) {
+    if (kHttpMethodNames[i] == name) {
+      return static_cast<HttpMethod>(i);
+    }
+  }
+  return HttpMethod::UNKNOWN;
+}
+
+constexpr uint32_t http_method_bit(HttpMethod method) {
+  return 1u << static_cast<uint32_t>(method);
+}
+
+// 把方法位掩码写成"GET, POST"形式（Allow头部），返回写入的字节数
+size_t http_format_allow(char *out, uint32_t methods);
+
+// 路由参数：名字指向路由表，值指向请求路径，都不拷贝
+class HttpRouteParams {
+private:
+  std::array<std::pair<std::string_view, std::string_view>,
+             HTTP_ROUTE_MAX_PARAMS>
+      params_;
+  size_t count_ = 0;
+
+public:
+  size_t size() const { return count_; }
+  std::string_view name(size_t index) const { return params_[index].first; }
+  std::string_view value(size_t index) const { return params_[index].second; }
+
+  // 没有该参数时返回空视图
+  std::string_view get(std::string_view name) const {
+    for (size_t i = 0; i < count_; ++i) {
+      if (params_[i].first == name) {
+        return params_[i].second;
+      }
+    }
+    return std::string_view();
+  }
+
+  void push(std::string_view name, std::string_view value) {
+    params_[count_++] = {name, value};
+  }
+  void pop() { --count_; }
+  void clear() { count_ = 0; }
+};
+
+// 路由前缀树（基数树）：静态片段按公共前缀合并，:name匹配一个路径段，
+// *name匹配剩余的全部路径（可以为空，只能在模式末尾）
+// 匹配优先级：静态 > :参数 > *通配，某分支对该方法无路由时回溯尝试下一种，
+// 查找开销只和路径长度有关，与路由条数无关
+class HttpRouteTree {
+private:
+  struct Node {
+    std::string prefix;  // 静态片段（进入节点时已消耗）
+    std::string indices; // 各静态子节点prefix的首字符，与children一一对应
+    std::vector<std::unique_ptr<Node>> children;
+    std::unique_ptr<Node> param;     // :name子节点
+    std::unique_ptr<Node> catch_all; // *name子节点（叶子）
+    std::string name;                // 参数节点的参数名
+    int32_t routes[HTTP_METHOD_COUNT]; // 各方法的路由编号，-1为没有
+    uint32_t methods = 0;              // 已注册方法的位掩码
+
+    Node();
+  };
+
+  Node root_;
+
+  // 插入静态片段，返回片段结束处的节点（必要时拆分已有节点）
+  static Node *insert_static(Node *node, std::string_view text);
+  static bool match(const Node *node, std::string_view path, HttpMethod method,
+                    HttpRouteParams &params, int32_t &route,
+                    uint32_t &allowed);
+  static bool match_here(const Node *node, HttpMethod method, int32_t &route,
+                         uint32_t &allowed);
+
+public:
+  // 模式须以/开头；重复注册、参数名冲突或格式错误时返回false
+  bool insert(HttpMethod method, std::string_view pattern, int32_t route);
+
+  // path不含查询串；找到时返回路由编号并填好params，否则返回-1，
+  // allowed为路径能匹配上的最具体节点所注册的方法（用于405的Allow）
+  int32_t find(HttpMethod method, std::string_view path,
+               HttpRouteParams &params, uint32_t &allowed) const;
+};
+
+// 路由表：模式编译进前缀树，处理函数按路由编号存放
+// 启动时注册完毕后只读，多个工作线程可以同时查找
+template <typename Handler> class HttpRouter {
+private:
+  HttpRouteTree tree_;
+  std::vector<Handler> handlers_;
+
+public:
+  bool add(HttpMethod method, std::string_view pattern, Handler handler) {
+    int32_t route = static_cast<int32_t>(handlers_.size());
+    if (!tree_.insert(method, pattern, route)) {
+      return false;
+    }
+    handlers_.push_back(std::move(handler));
+    return true;
+  }
+
+  bool get(std::string_view pattern, Handler handler) {
+    return add(HttpMethod::GET, pattern, std::move(handler));
+  }
+  bool post(std::string_view pattern, Handler handler) {
+    return add(HttpMethod::POST, pattern, std::move(handler));
+  }
+
+  size_t size() const { return handlers_.size(); }
+
+  // 没有匹配的路由时返回nullptr：allowed非0应回复405，否则404
+  const Handler *find(HttpMethod method, std::string_view path,
+                      HttpRouteParams &params, uint32_t &allowed) const {
+    int32_t route = tree_.find(method, path, params, allowed);
+    return route < 0 ? nullptr : &handlers_[route];
+  }
+};
@@ -0,0 +1,26 @@
+#pragma once
+// C++标准库头文件
+#include <cstddef>
+
+// HTTP报文扫描内核：一次检查16/32字节，运行时按CPU特性选择，标量实现兜底
+enum class HttpScanKernel {
+  SCALAR, // 逐字节
+  SSE42,  // pcmpestri范围比较，16字节/次
+  AVX2,   // 256位比较+掩码，32字节/次
+};
+
+// 返回[data, data+size)中第一个"需要状态机处理"的字节下标，没有则返回size
+// 需要处理的字节：控制字符（水平制表符除外）、DEL(0x7f)以及delim本身
+// 因为\r \n都是控制字符，所以同时也就定位了行尾
+size_t http_scan(const char *data, size_t size, char delim);
+
+// 当前使用的内核（首次调用时按CPU特性自动选择）
+HttpScanKernel http_scan_kernel();
+
+// 强制切换内核（基准测试用），CPU不支持时返回false
+bool http_scan_set_kernel(HttpScanKernel kernel);
+
+// CPU是否支持该内核
+bool http_scan_kernel_supported(HttpScanKernel kernel);
+
+const char *http_scan_kernel_name(HttpScanKernel kernel);
@@ -0,0 +1,56 @@
+#pragma once
+// C++标准库头文件
+#include <cstddef>
+#include <cstdint>
+
+// 流式响应专用配置
+#define HTTP_STREAM_MIN_SPACE 512     // 写缓冲区剩余空间低于此值时等下一次写完成
+#define HTTP_STREAM_MAX_CHUNK 0xffffff // 单个分块最大长度（6位十六进制）
+
+// 流式响应体的数据源（拉取模式）：只在写缓冲区有空间时被调用，
+// 写不出去就不会再被拉取，内存占用以写缓冲区为上限
+// 写完成后由事件循环线程继续拉取，produce不能阻塞：由事件循环驱动的连接
+// 只能用内存中的数据源，文件内容交给环上的文件流（UringFileStream）读取；
+// 读文件的数据源只用于不由事件循环驱动的连接（ring_file_io为false）
+class HttpBodyProducer {
+public:
+  virtual ~HttpBodyProducer() = default;
+  // 向[out, out+capacity)写入下一段响应体，返回写入的字节数
+  // 没有更多数据时把finished置为true（可以同时返回最后一段）；
+  // 未结束时必须返回数据，返回0视为结束
+  virtual size_t produce(char *out, size_t capacity, bool &finished) = 0;
+};
+
+// 响应体的分帧方式
+enum class HttpBodyFraming : uint8_t {
+  CONTENT_LENGTH, // 长度已知
+  CHUNKED,        // 长度未知，HTTP/1.1分块编码
+  UNTIL_CLOSE,    // 长度未知且客户端不支持分块，关闭连接表示结束
+};
+
+// 连接上正在进行的流式响应：按分帧方式把生产者的输出编码进写缓冲区
+class HttpResponseStream {
+private:
+  HttpBodyProducer *producer_ = nullptr; // 对象位于请求分配区
+  HttpBodyFraming framing_ = HttpBodyFraming::CONTENT_LENGTH;
+  size_t remaining_ = 0; // CONTENT_LENGTH模式下还需输出的字节数
+  bool finished_ = false;
+  bool truncated_ = false; // 数据源提前结束，实际长度少于Content-Length
+
+  // 一次拉取，返回写入的字节数（含分块头尾）
+  size_t pump_once(char *out, size_t capacity);
+
+public:
+  void start(HttpBodyProducer *producer, HttpBodyFraming framing,
+             size_t content_length);
+
+  // 尽量填满[out, out+capacity)，返回写入的字节数
+  size_t pump(char *out, size_t capacity);
+
+  // 销毁数据源（内存随请求分配区回收）
+  void close();
+
+  bool active() const { return producer_ != nullptr; }
+  bool finished() const { return finished_; }
+  bool truncated() const { return truncated_; }
+};
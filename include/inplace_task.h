@@ -0,0 +1,101 @@
+#pragma once
+// C++标准库头文件
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 任务对象专用配置
+#define INPLACE_TASK_CAPACITY 48 // 内联存放可调用对象的字节数，放不下的才上堆
+
+// 只能移动的void()任务：可调用对象不超过INPLACE_TASK_CAPACITY且移动不抛异常
+// 时直接构造在对象内部，不像std::function那样要求可拷贝，也不额外分配内存
+class InplaceTask {
+private:
+  using Invoke = void (*)(void *);
+  // 把src处的对象移动构造到dst（dst为nullptr时只销毁）并销毁src
+  using Manage = void (*)(void *dst, void *src);
+
+  template <typename Fn>
+  static constexpr bool fits_inline =
+      sizeof(Fn) <= INPLACE_TASK_CAPACITY &&
+      alignof(Fn) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<Fn>;
+
+  template <typename Fn> static void invoke_inline(void *storage) {
+    (*static_cast<Fn *>(storage))();
+  }
+  template <typename Fn> static void manage_inline(void *dst, void *src) {
+    Fn *fn = static_cast<Fn *>(src);
+    if (dst != nullptr) {
+      new (dst) Fn(std::move(*fn));
+    }
+    fn->~Fn();
+  }
+  template <typename Fn> static void invoke_heap(void *storage) {
+    (**static_cast<Fn **>(storage))();
+  }
+  template <typename Fn> static void manage_heap(void *dst, void *src) {
+    Fn *fn = *static_cast<Fn **>(src);
+    if (dst != nullptr) {
+      *static_cast<Fn **>(dst) = fn;
+    } else {
+      delete fn;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[INPLACE_TASK_CAPACITY];
+  Invoke invoke_ = nullptr;
+  Manage manage_ = nullptr;
+
+  void move_from(InplaceTask &other) noexcept {
+    if (other.manage_ != nullptr) {
+      other.manage_(storage_, other.storage_);
+      invoke_ = other.invoke_;
+      manage_ = other.manage_;
+      other.invoke_ = nullptr;
+      other.manage_ = nullptr;
+    }
+  }
+
+public:
+  InplaceTask() = default;
+
+  template <typename F, typename Fn = std::decay_t<F>,
+            typename = std::enable_if_t<!std::is_same_v<Fn, InplaceTask>>>
+  InplaceTask(F &&f) {
+    if constexpr (fits_inline<Fn>) {
+      new (storage_) Fn(std::forward<F>(f));
+      invoke_ = &invoke_inline<Fn>;
+      manage_ = &manage_inline<Fn>;
+    } else {
+      *reinterpret_cast<Fn **>(storage_) = new Fn(std::forward<F>(f));
+      invoke_ = &invoke_heap<Fn>;
+      manage_ = &manage_heap<Fn>;
+    }
+  }
+
+  InplaceTask(InplaceTask &&other) noexcept { move_from(other); }
+  InplaceTask &operator=(InplaceTask &&other) noexcept {
+    if (this != &other) {
+      reset();
+      move_from(other);
+    }
+    return *this;
+  }
+  InplaceTask(const InplaceTask &) = delete;
+  InplaceTask &operator=(const InplaceTask &) = delete;
+  ~InplaceTask() { reset(); }
+
+  // 销毁持有的可调用对象（连同它捕获的状态）
+  void reset() noexcept {
+    if (manage_ != nullptr) {
+      manage_(nullptr, storage_);
+      invoke_ = nullptr;
+      manage_ = nullptr;
+    }
+  }
+
+  explicit operator bool() const { return invoke_ != nullptr; }
+  void operator()() { invoke_(storage_); }
+};
@@ -3,21 +3,35 @@
 // C++标准库头文件
 #include <iostream>
 #include <string>
+#include <utility>
 
 // 项目内头文件 - 集成lib中的组件
 #include "../lib/cache_pool/buddy_pool/buddy_pool.h"
+#include "../lib/cache_pool/slab_pool/size_class_pool.h"
 #include "../lib/cache_pool/slab_pool/slab_pool.h"
 #include "uring_types.h"
 
+// 内存回收策略：常驻内存超过高水位才开始回收，回收到低水位即停，
+// 两者之间留出余量，避免负载抖动时反复释放又申请
+struct MemoryTrimPolicy {
+  size_t high_watermark = MEMORY_HIGH_WATERMARK;
+  size_t low_watermark = MEMORY_LOW_WATERMARK;
+  size_t connection_slab_reserve = MEMORY_CONNECTION_SLAB_RESERVE;
+  size_t size_class_slab_reserve = MEMORY_SIZE_CLASS_SLAB_RESERVE;
+};
+
 // 内存池分层设计 - 集成lib中的缓存池组件
 class LayerMemoryPool {
 private:
   // 连接对象池 - 使用slab池管理连接对象
   SlabConnectionPool<UringConnectionInfo> connection_pool;
 
-  // 缓冲区内存池 - 使用buddy池管理内存缓存
+  // 缓冲区内存池 - 使用buddy池管理内存缓存（大块）
   Buffer_BuddySystem cache_pool;
 
+  // 小对象池 - 按尺寸分级的slab，承接SIZE_CLASS_MAX_SIZE以内的对象
+  SizeClassPool object_pool;
+
 public:
   // 构造函数
   LayerMemoryPool(size_t max_connections = URING_MAX_CONNECTIONS,
@@ -33,6 +47,19 @@ public:
 
   void release_connection(UringConnectionInfo *conn) {
     if (conn) {
+      // 连接中途断开时额外缓冲区可能还没归还
+      if (conn->extra_buffer) {
+        cache_pool.deallocate_buffer(conn->extra_buffer);
+        conn->extra_buffer = nullptr;
+        conn->extra_buffer_in_use = false;
+        conn->extra_buffer_filled = 0;
+        conn->bytes_NO_read = 0;
+      }
+      // 流式响应没写完就断开时，数据源持有的文件描述符在这里关闭
+      conn->response_stream.close();
+      conn->clear_output_segment();
+      conn->file_op.reset();
+      conn->file_stream.close();
       connection_pool.release(conn);
     }
   }
@@ -48,11 +75,66 @@ public:
 
   void defragment_cache() { cache_pool.defragment(); }
 
+  // 单个连接对象的实际占用（对象本身 + 读写环形缓冲区）
+  static constexpr size_t connection_footprint() {
+    return sizeof(UringConnectionInfo) + 2 * URING_BUFFER_SIZE;
+  }
+
+  // 常驻内存估算：连接slab + 小对象slab + 伙伴系统未归还部分
+  size_t get_resident_bytes() {
+    return connection_pool.get_slab_count() * 64 * connection_footprint() +
+           object_pool.get_reserved_bytes() + cache_pool.get_resident_bytes();
+  }
+
+  // 回收一轮，返回归还的字节数（估算）；由事件循环定期调用
+  // 先归还伙伴系统空闲页（不影响后续分配），再释放多余的空slab
+  size_t trim(const MemoryTrimPolicy &policy) {
+    size_t resident = get_resident_bytes();
+    if (resident <= policy.high_watermark) {
+      return 0;
+    }
+
+    size_t released = cache_pool.release_free_memory();
+    if (resident - released > policy.low_watermark) {
+      released += object_pool.trim(policy.size_class_slab_reserve,
+                                   resident - released - policy.low_watermark);
+    }
+    if (resident - released > policy.low_watermark) {
+      size_t slab_bytes = 64 * connection_footprint();
+      size_t excess = resident - released - policy.low_watermark;
+      size_t slabs = (excess + slab_bytes - 1) / slab_bytes;
+      released += connection_pool.trim(policy.connection_slab_reserve, slabs) *
+                  slab_bytes;
+    }
+    return released;
+  }
+
+  // 通用分配接口：小对象走尺寸分级slab，大块走伙伴系统
+  void *allocate(size_t size) {
+    if (size <= SIZE_CLASS_MAX_SIZE) {
+      return object_pool.allocate(size);
+    }
+    return cache_pool.allocate_buffer(size);
+  }
+
+  // 释放时需要传入分配时的大小，以便路由回同一个池
+  void deallocate(void *ptr, size_t size) {
+    if (!ptr)
+      return;
+    if (size <= SIZE_CLASS_MAX_SIZE) {
+      object_pool.deallocate(ptr);
+    } else {
+      cache_pool.deallocate_buffer(static_cast<char *>(ptr));
+    }
+  }
+
   // 对象池管理接口
   template <typename ObjectType>
   ObjectType *allocate_objects(size_t count = 1) {
+    static_assert(alignof(ObjectType) <= SIZE_CLASS_MIN_SIZE,
+                  "对象对齐要求超过内存池保证的对齐");
     size_t total_size = sizeof(ObjectType) * count;
-    char *buffer = allocate_buffer(total_size);
+    void *buffer = allocate(total_size);
     if (!buffer)
       return nullptr;
 
@@ -75,9 +157,29 @@ public:
     }
 
     // 释放内存
-    deallocate_buffer(reinterpret_cast<char *>(objects));
+    deallocate(objects, sizeof(ObjectType) * count);
+  }
+
+  // 类型化单对象接口：带构造参数，替代全局new/delete
+  template <typename ObjectType, typename... Args>
+  ObjectType *create(Args &&...args) {
+    static_assert(alignof(ObjectType) <= SIZE_CLASS_MIN_SIZE,
+                  "对象对齐要求超过内存池保证的对齐");
+    void *buffer = allocate(sizeof(ObjectType));
+    if (!buffer)
+      return nullptr;
+    return new (buffer) ObjectType(std::forward<Args>(args)...);
+  }
+
+  template <typename ObjectType> void destroy(ObjectType *object) {
+    if (!object)
+      return;
+    object->~ObjectType();
+    deallocate(object, sizeof(ObjectType));
   }
 
+  void print_object_stats() { object_pool.print_stats(); }
+
   // 监控和统计接口
   struct CacheStats {
     size_t fragmentation;    // 碎片率
@@ -121,4 +223,44 @@ public:
     }
     return "HEALTHY: Memory pool is operating normally";
   }
+};
+
+// STL分配器适配：让解析器、请求头、响应对象等容器从内存池取内存
+// 用法：std::vector<char, LayerPoolAllocator<char>> v(LayerPoolAllocator<char>(pool));
+template <typename T> class LayerPoolAllocator {
+private:
+  LayerMemoryPool *_pool;
+
+  template <typename U> friend class LayerPoolAllocator;
+
+public:
+  using value_type = T;
+
+  explicit LayerPoolAllocator(LayerMemoryPool *pool) noexcept : _pool(pool) {}
+
+  template <typename U>
+  LayerPoolAllocator(const LayerPoolAllocator<U> &other) noexcept
+      : _pool(other._pool) {}
+
+  T *allocate(size_t n) {
+    void *ptr = _pool->allocate(n * sizeof(T));
+    if (!ptr) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T *>(ptr);
+  }
+
+  void deallocate(T *ptr, size_t n) noexcept {
+    _pool->deallocate(ptr, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const LayerPoolAllocator<U> &other) const noexcept {
+    return _pool == other._pool;
+  }
+
+  template <typename U>
+  bool operator!=(const LayerPoolAllocator<U> &other) const noexcept {
+    return _pool != other._pool;
+  }
 };
\ No newline at end of file
@@ -1,24 +1,254 @@
 #pragma once
+// C系统头文件
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// C++标准库头文件
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <future>
-#include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <random>
+#include <stdexcept>
 #include <thread>
 #include <type_traits>
-#include <uring_types.h>
 #include <vector>
+
+// 项目头文件
+#include "inplace_task.h"
+#include "work_stealing_deque.h"
+#include <uring_types.h>
+
+// 线程池专用配置
+#define THREAD_POOL_DEQUE_CAPACITY 256 // 每个双端队列的初始容量（2的幂，满了翻倍）
+#define THREAD_POOL_SPIN_ROUNDS 64     // 找不到任务时休眠前的自旋轮数
+#define THREAD_POOL_STEAL_ROUNDS 2     // 每轮自旋遍历所有队列窃取的次数
+#define THREAD_POOL_NODE_CHUNK 64      // 任务节点不够用时一次分配的个数
+
+// 工作窃取线程池：每个工作线程一个Chase-Lev双端队列，工作线程提交的任务
+// 进自己的队列；第一个提交任务的外部线程（事件循环线程）独占一个队列，
+// 提交时只写自己的队列底部，不和工作线程争锁；其他外部线程走加锁的注入队列
+// 空闲的工作线程从随机的队列顶部窃取，自旋一阵仍没有任务时在futex上休眠
+// 任务放在复用的节点里，稳态下提交和执行都不分配内存
 class ThreadPool {
 private:
+  struct TaskNode {
+    InplaceTask task;
+    TaskNode *next;
+    size_t home; // 所属节点缓存的编号
+  };
+
+  // 节点缓存：所属线程从free取，执行完的线程归还到returned；returned只有
+  // 所属线程整条取走，多个归还者压栈不会遇到ABA
+  struct alignas(64) NodeCache {
+    TaskNode *free = nullptr; // 只由所属线程访问
+    alignas(64) std::atomic<TaskNode *> returned{nullptr};
+    std::vector<std::unique_ptr<TaskNode[]>> chunks;
+  };
+
   std::vector<std::thread> _workers; // 工作线程
-  std::queue<std::function<void()>>
-      _tasks;             // 任务队列 //利用function多态函数封装器
-  std::mutex _queueMutex; // 队列互斥锁
-  std::condition_variable _condition; // 条件变量
-  std::atomic<bool> _stop;            // 设置停止状态
-  // std::shared_ptr<MainThreadTaskQueue> _main_queue; // 主线程任务队列
+  // 0..n-1属于工作线程，n属于独占提交队列的外部线程
+  std::vector<std::unique_ptr<WorkStealingDeque<TaskNode>>> _deques;
+  // 与队列一一对应，多出的最后一个给注入队列的提交者（持锁访问）
+  std::vector<std::unique_ptr<NodeCache>> _caches;
+  std::atomic<std::thread::id> _submitter; // 独占第n个队列的外部线程
+  std::mutex _injectMutex;                 // 其他外部线程的注入队列
+  std::deque<TaskNode *> _injected;
+  std::atomic<size_t> _injectedCount{0};
+  alignas(64) std::atomic<uint32_t> _epoch{0}; // futex字，唤醒时加1
+  alignas(64) std::atomic<uint32_t> _sleepers{0};
+  std::atomic<bool> _stop; // 设置停止状态
+
+  // 当前线程所属的线程池和队列编号（不是工作线程时为nullptr）
+  static inline thread_local ThreadPool *t_pool = nullptr;
+  static inline thread_local size_t t_index = 0;
+
+  static void futex_wait(std::atomic<uint32_t> *word, uint32_t expected) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word),
+            FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+  }
+  static void futex_wake(std::atomic<uint32_t> *word, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word),
+            FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+  }
+
+  static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  bool has_work() const {
+    if (_injectedCount.load(std::memory_order_relaxed) > 0) {
+      return true;
+    }
+    for (const auto &deque : _deques) {
+      if (!deque->empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // 只由缓存所属线程调用：空了先整条取回归还的节点，仍没有再分配一批
+  TaskNode *acquire_node(size_t home) {
+    NodeCache &cache = *_caches[home];
+    if (cache.free == nullptr) {
+      cache.free = cache.returned.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (cache.free == nullptr) {
+      auto chunk = std::make_unique<TaskNode[]>(THREAD_POOL_NODE_CHUNK);
+      for (size_t i = 0; i < THREAD_POOL_NODE_CHUNK; ++i) {
+        chunk[i].home = home;
+        chunk[i].next =
+            i + 1 < THREAD_POOL_NODE_CHUNK ? &chunk[i + 1] : nullptr;
+      }
+      cache.free = chunk.get();
+      cache.chunks.push_back(std::move(chunk));
+    }
+    TaskNode *node = cache.free;
+    cache.free = node->next;
+    return node;
+  }
+
+  // 执行完的节点：自己的直接放回，别人的压到所属缓存的归还栈
+  void release_node(TaskNode *node, size_t self) {
+    node->task.reset();
+    NodeCache &cache = *_caches[node->home];
+    if (node->home == self) {
+      node->next = cache.free;
+      cache.free = node;
+      return;
+    }
+    TaskNode *head = cache.returned.load(std::memory_order_relaxed);
+    do {
+      node->next = head;
+    } while (!cache.returned.compare_exchange_weak(
+        head, node, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  TaskNode *pop_injected() {
+    if (_injectedCount.load(std::memory_order_relaxed) == 0) {
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(_injectMutex);
+    if (_injected.empty()) {
+      return nullptr;
+    }
+    TaskNode *task = _injected.front();
+    _injected.pop_front();
+    _injectedCount.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+  }
+
+  // 先取自己队列的底部，再看注入队列，最后从随机位置开始轮流窃取
+  TaskNode *find_task(size_t self, std::minstd_rand &rng) {
+    if (TaskNode *task = _deques[self]->pop()) {
+      return task;
+    }
+    if (TaskNode *task = pop_injected()) {
+      return task;
+    }
+    size_t count = _deques.size();
+    for (int round = 0; round < THREAD_POOL_STEAL_ROUNDS; ++round) {
+      size_t start = rng() % count;
+      for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if (victim == self) {
+          continue;
+        }
+        if (TaskNode *task = _deques[victim]->steal()) {
+          return task;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  // 先登记休眠再复查：提交方入队后看到休眠者就推进epoch并唤醒，
+  // 复查和futex对epoch的比较保证不会错过唤醒
+  void park() {
+    uint32_t epoch = _epoch.load(std::memory_order_acquire);
+    _sleepers.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!has_work() && !_stop.load(std::memory_order_acquire)) {
+      futex_wait(&_epoch, epoch);
+    }
+    _sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void notify_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_sleepers.load(std::memory_order_seq_cst) > 0) {
+      _epoch.fetch_add(1, std::memory_order_release);
+      futex_wake(&_epoch, 1);
+    }
+  }
+
+  void worker_loop(size_t index) {
+    t_pool = this;
+    t_index = index;
+    std::minstd_rand rng(static_cast<uint32_t>(index) + 1);
+    int idle = 0;
+    while (true) {
+      if (TaskNode *task = find_task(index, rng)) {
+        idle = 0;
+        task->task();
+        release_node(task, index);
+        continue;
+      }
+      // 收到停止信号且所有队列都空了，线程退出
+      if (_stop.load(std::memory_order_acquire) && !has_work()) {
+        return;
+      }
+      if (++idle < THREAD_POOL_SPIN_ROUNDS) {
+        cpu_relax();
+        continue;
+      }
+      idle = 0;
+      park();
+    }
+  }
+
+  // 按提交线程选队列：工作线程用自己的，事件循环线程用独占的，其他加锁
+  // 节点从提交线程自己的缓存取
+  template <typename F> void submit(F &&f) {
+    if (_stop.load(std::memory_order_acquire)) {
+      throw std::runtime_error("enqueue on stopped ThreadPool");
+    }
+    InplaceTask task(std::forward<F>(f));
+    size_t slot = _workers.size();
+    if (t_pool == this) {
+      slot = t_index;
+    } else {
+      std::thread::id self = std::this_thread::get_id();
+      std::thread::id owner = _submitter.load(std::memory_order_acquire);
+      if (owner == std::thread::id() &&
+          _submitter.compare_exchange_strong(owner, self)) {
+        owner = self;
+      }
+      if (owner != self) {
+        std::lock_guard<std::mutex> lock(_injectMutex);
+        TaskNode *node = acquire_node(_caches.size() - 1);
+        node->task = std::move(task);
+        _injected.push_back(node);
+        _injectedCount.fetch_add(1, std::memory_order_relaxed);
+        notify_one();
+        return;
+      }
+    }
+    TaskNode *node = acquire_node(slot);
+    node->task = std::move(task);
+    _deques[slot]->push(node);
+    notify_one();
+  }
 
 public:
   // 构造函数，创建指定数量的工作线程
@@ -26,38 +256,20 @@ public:
       size_t threadCount = std::thread::
           hardware_concurrency() // 静态函数获取当前系统cpu逻辑核心数
       )
-      : _stop(false) {
+      : _submitter(std::thread::id()), _stop(false) {
 
     if (threadCount == 0) {
       threadCount = 4; // 默认四个线程
     }
-    // 构造函数里面需要为线程队列做处理
+    // 队列先全部建好，工作线程启动后就可能互相窃取
+    for (size_t i = 0; i <= threadCount; ++i) {
+      _deques.push_back(std::make_unique<WorkStealingDeque<TaskNode>>(
+          THREAD_POOL_DEQUE_CAPACITY));
+      _caches.push_back(std::make_unique<NodeCache>());
+    }
+    _caches.push_back(std::make_unique<NodeCache>());
     for (size_t i = 0; i < threadCount; ++i) {
-      _workers.emplace_back([this] {
-        while (true) {
-          std::function<void()> task; // 创建函数 任务
-          {
-            std::unique_lock<std::mutex> lock(this->_queueMutex);
-            // 等待任务或者停止信号
-            this->_condition.wait(lock, [this] { // 谓词函数用于检查得带条件
-              return this->_stop ||
-                     !this->_tasks
-                          .empty(); // 队列为空或者原子标志为1的时候返回真
-            });
-            // 如果收到停止信号且任务队列为空，则线程退出；
-            if (this->_stop && this->_tasks.empty()) {
-              return;
-            }
-            // 取出一个任务
-            task = std::move(this->_tasks.front());
-            this->_tasks.pop();
-            std::cout << "线程 " << std::this_thread::get_id()
-                      << " 开始执行任务" << std::endl;
-          }
-          // 执行任务
-          task();
-        }
-      });
+      _workers.emplace_back([this, i] { worker_loop(i); });
     }
   }
   // 禁止拷贝构造和赋值
@@ -66,30 +278,20 @@ public:
   // 提交任务到线程池，返回future 一边获取结果
   template <typename F, typename... Args>
   auto enqueue(F &&f, Args &&...args) // 这里面是参数列表
-      -> std::future<std::invoke_result_t<
-          F, Args...>> // 修复：直接使用std::invoke_result_t
-  {                    // typename 一般是声明他是个类型
-    using return_type =
-        std::invoke_result_t<F, Args...>; // 修复：直接使用std::invoke_result_t
+      -> std::future<std::invoke_result_t<F, Args...>> {
+    using return_type = std::invoke_result_t<F, Args...>;
     // 将任务封装到packeaged_task中，以便获取future
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
+    std::packaged_task<return_type()> task(
         std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-    std::future<return_type> result = task->get_future(); // 获取返回值；
-    // 作用域 自动解锁
-    {
-      std::unique_lock<std::mutex> lock(_queueMutex); // 加锁放入队列
-      // 不允许在停止线程后添加任务
-      if (_stop) {
-        throw std::runtime_error("enqueue on stoppend ThreadPool");
-      }
-      // 将任务添加到队列
-      _tasks.emplace([task]() { (*task)(); });
-    }
-    // 通知一个线程；
-    _condition.notify_one();
+    std::future<return_type> result = task.get_future(); // 获取返回值；
+    submit([task = std::move(task)]() mutable { task(); });
     return result;
   }
 
+  // 提交不需要结果的任务：不创建future，可调用对象放得下时不分配内存
+  // 任务抛出的异常不会被捕获
+  template <typename F> void post(F &&f) { submit(std::forward<F>(f)); }
+
   // 提交带回调的任务到线程池
   template <typename F, typename... Args>
   auto
@@ -97,7 +299,7 @@ public:
                         std::function<void(UringConnectionInfo *)> callback,
                         Args &&...args) -> std::future<void> {
 
-    auto task = std::make_shared<std::packaged_task<void()>>(
+    std::packaged_task<void()> task(
         [f = std::forward<F>(f), conn, callback, args...]() mutable {
           // 执行任务
           std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
@@ -108,27 +310,20 @@ public:
           }
         });
 
-    std::future<void> result = task->get_future();
-    {
-      std::unique_lock<std::mutex> lock(_queueMutex);
-      if (_stop) {
-        throw std::runtime_error("enqueue on stopped ThreadPool");
-      }
-      _tasks.emplace([task]() { (*task)(); });
-    }
-    _condition.notify_one();
+    std::future<void> result = task.get_future();
+    submit([task = std::move(task)]() mutable { task(); });
     return result;
   }
 
-  // // 设置主线程任务队列，设置这个回调太慢了（运行速度）
-  // void set_main_queue(std::shared_ptr<MainThreadTaskQueue> main_queue) {
-  //   _main_queue = main_queue;
-  // }
-  // 获取当前等待执行的任务数量
+  // 获取当前等待执行的任务数量（近似值，返回时可能已改变）
   size_t pendingTasks() const {
-    return _tasks
-        .size(); // 注意：这个方法不是线程安全的，可能在返回时队列大小已改变
+    size_t pending = _injectedCount.load(std::memory_order_relaxed);
+    for (const auto &deque : _deques) {
+      pending += deque->size();
+    }
+    return pending;
   }
+  size_t threadCount() const { return _workers.size(); }
   // 获取线程运行状态
   bool isRunning() const {
     return !_stop; // 停止标志取反：true表示运行中，false表示已停止
@@ -139,14 +334,11 @@ public:
       std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
   }
-  // 立即关闭线程池（不等待未完成的任务）
+  // 停止接收任务，工作线程执行完已提交的任务后退出
   void shutdown() {
-
-    {
-      std::unique_lock<std::mutex> lock(_queueMutex); // 加锁并设置退出标志
-      _stop = true;
-    } // 括号的作用是解锁
-    _condition.notify_all();
+    _stop.store(true, std::memory_order_release);
+    _epoch.fetch_add(1, std::memory_order_release);
+    futex_wake(&_epoch, INT32_MAX);
     for (std::thread &worker : _workers) {
       if (worker.joinable()) { // 检查线程是否可以join
         worker.join();
@@ -159,4 +351,4 @@ public:
       shutdown();
     }
   }
-};
\ No newline at end of file
+};
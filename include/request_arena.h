@@ -0,0 +1,31 @@
+#pragma once
+
+// C++标准库头文件
+#include <cstddef>
+#include <memory_resource>
+
+// 请求分配区专用配置
+#define REQUEST_ARENA_INLINE_SIZE (8 * 1024) // 内联缓冲区，覆盖常见请求
+
+// 每连接的单调（bump）分配区
+// 一个请求解析与响应构造期间的所有容器（请求头表、响应头、响应体等）都从这里分配，
+// 响应写入写缓冲区后整体reset，稳态下不触碰全局堆；超出内联区的部分才向上游申请
+class RequestArena {
+private:
+  alignas(std::max_align_t) char _inline[REQUEST_ARENA_INLINE_SIZE];
+  std::pmr::monotonic_buffer_resource _resource;
+
+public:
+  explicit RequestArena(
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : _resource(_inline, sizeof(_inline), upstream) {}
+
+  // 禁用拷贝构造和赋值（内部指针指向自身内联区）
+  RequestArena(const RequestArena &) = delete;
+  RequestArena &operator=(const RequestArena &) = delete;
+
+  std::pmr::memory_resource *resource() { return &_resource; }
+
+  // 归还本次请求用过的全部内存，回到内联缓冲区起点
+  void reset() { _resource.release(); }
+};
@@ -0,0 +1,99 @@
+#pragma once
+// C++标准库头文件
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 项目头文件
+#include "http_response.h"
+#include "static_file_cache.h"
+
+// 静态归档专用配置
+#define STATIC_ARCHIVE_ENABLED 0 // 1: 启动时把静态根目录打包成一个文件，mmap后从映射直接发送
+#define STATIC_ARCHIVE_FILE "static.pack" // 归档文件路径，已存在且有效时直接映射
+#define STATIC_ARCHIVE_ALIGN 64           // 响应体在归档内的对齐字节数
+#define STATIC_ARCHIVE_BUCKET_SIZE 4      // 完美哈希平均每桶的路径数
+
+// 归档中一种编码的表示，全部是映射内的视图，字段含义同StaticCacheVariant
+struct StaticArchiveVariant {
+  std::string_view headers;
+  std::string_view body;
+  std::string_view etag;
+  size_t validators_offset = 0;
+
+  std::string_view validators() const {
+    return headers.substr(validators_offset);
+  }
+};
+
+// 归档中的一个文件，接口与StaticCacheEntry一致，发送路径对两者通用
+struct StaticArchiveFile {
+  StaticArchiveVariant variants[static_cast<size_t>(ContentEncoding::COUNT)];
+  std::string_view path;
+  HttpMime mime = HttpMime::OCTET_STREAM;
+  time_t last_modified = 0;
+
+  const StaticArchiveVariant &identity() const { return variants[0]; }
+  const StaticArchiveVariant &variant(ContentEncoding encoding) const {
+    return variants[static_cast<size_t>(encoding)];
+  }
+  bool has_variant(ContentEncoding encoding) const {
+    return encoding == ContentEncoding::IDENTITY ||
+           !variant(encoding).body.empty();
+  }
+};
+
+// 静态归档：整个静态根目录打包成一个文件，只读mmap
+// 文件布局：头部、各桶位移、按槽位排列的条目表、路径和头部字符串、
+// 按STATIC_ARCHIVE_ALIGN对齐的响应体。路径索引是最小完美哈希
+// （先按种子0分桶，每桶再找一个种子把桶内路径映射到互不冲突的空槽），
+// 查找是两次哈希、一次边界检查和一次路径比较，服务时不打开任何文件
+// 映射后只读，多个工作线程可以同时查找（open只在启动时调用）
+class StaticArchive {
+public:
+  using FilePtr = std::shared_ptr<const StaticArchiveFile>;
+
+private:
+  // 一次映射和从中解析出的索引，析构时munmap；find返回的指针与它共享
+  // 所有权，重新open换上新的映射后，还在发送的响应仍持有旧的条目和映射
+  struct Mapping {
+    const char *data;
+    size_t size;
+    std::vector<uint32_t> seeds;          // 各桶的第二级种子（从映射拷贝）
+    std::vector<StaticArchiveFile> files; // 按槽位排列，从条目表解析
+
+    Mapping(const char *base, size_t length) : data(base), size(length) {}
+    ~Mapping();
+    Mapping(const Mapping &) = delete;
+    Mapping &operator=(const Mapping &) = delete;
+
+    const StaticArchiveFile *lookup(std::string_view path) const;
+  };
+
+  std::shared_ptr<const Mapping> mapping_;
+
+  static uint64_t hash(std::string_view path, uint64_t seed);
+
+public:
+  StaticArchive() = default;
+
+  static StaticArchive &instance();
+
+  // 遍历root下的文件（跳过预压缩的.gz/.br）生成归档，先写临时文件再改名
+  static bool pack(const std::string &root, const std::string &archive_path);
+
+  // 映射并校验归档（所有偏移都在文件范围内），失败时不改变当前的映射
+  bool open(const std::string &archive_path);
+
+  bool mapped() const { return mapping_ != nullptr; }
+  size_t size() const { return mapping_ ? mapping_->files.size() : 0; }
+  size_t mapped_bytes() const { return mapping_ ? mapping_->size : 0; }
+
+  // path为规范化路径；不在归档中时返回nullptr
+  // 返回的指针与映射共享所有权，响应体可以直接从映射写出
+  FilePtr find(std::string_view path) const;
+};
@@ -0,0 +1,189 @@
+#pragma once
+// C++标准库头文件
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <future>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 项目头文件
+#include "http_response.h"
+
+// 静态文件缓存专用配置
+#define HTTP_STATIC_ROOT "../../html"              // 静态文件根目录
+#define STATIC_CACHE_SHARDS 16                     // 分片数，按路径哈希分散锁竞争
+#define STATIC_CACHE_BUDGET (64 * 1024 * 1024)     // 缓存总字节预算
+#define STATIC_CACHE_MAX_ENTRY (4 * 1024 * 1024)   // 超过此大小的文件不缓存，走流式响应
+#define STATIC_CACHE_INLINE_BODY 2048              // 不超过此大小的响应体直接拷进写缓冲区
+#define STATIC_CACHE_REVALIDATE_SECONDS 2          // 条目超过此秒数后重新stat确认文件未变
+#define STATIC_CACHE_MIN_COMPRESS 256              // 小于此大小的文件不生成压缩版本
+#define STATIC_CACHE_GZIP_LEVEL 9                  // 预加载和打包时一次性压缩，用最高压缩级别
+#define STATIC_CACHE_BROTLI_QUALITY 11
+#define STATIC_CACHE_FAST_GZIP_LEVEL 1             // 请求路径上按需加载时用快速级别
+#define STATIC_CACHE_FAST_BROTLI_QUALITY 2
+
+// 规范化请求路径：去掉查询串，解码%XX，合并多余的/，处理.和..
+// 结果总是以/开头；..越过根目录、含NUL或编码的/时返回false
+bool http_normalize_path(std::string_view url, std::pmr::string &out);
+
+// 响应体的内容编码，按优先级从低到高排列
+enum class ContentEncoding : uint8_t {
+  IDENTITY,
+  GZIP,
+  BROTLI,
+  COUNT,
+};
+
+// 一种编码下的完整表示：预先格式化好的实体头部和内容
+struct StaticCacheVariant {
+  // Content-Type、Content-Length、Content-Encoding、Accept-Ranges、Vary、
+  // ETag、Last-Modified头部行（含\r\n）
+  std::string headers;
+  std::string body;
+  std::string etag; // 强ETag（含引号），压缩版本带编码后缀
+  size_t validators_offset = 0; // 304需要的头部（Vary起）在headers中的起点
+
+  std::string_view validators() const {
+    return std::string_view(headers).substr(validators_offset);
+  }
+};
+
+// 缓存条目：文件的各编码表示，创建后只读，多线程共享
+// 压缩版本在加载时生成一次（或读取同目录下的.gz/.br文件），没有时body为空
+struct StaticCacheEntry {
+  StaticCacheVariant variants[static_cast<size_t>(ContentEncoding::COUNT)];
+  HttpMime mime;
+  time_t last_modified; // 秒级修改时间，用于If-Modified-Since
+  int64_t mtime_ns;     // 文件修改时间，用于确认文件未变
+  mutable std::atomic<time_t> checked_at; // 最近一次确认文件未变的时间
+
+  StaticCacheEntry()
+      : mime(HttpMime::OCTET_STREAM), last_modified(0), mtime_ns(0),
+        checked_at(0) {}
+
+  const StaticCacheVariant &identity() const { return variants[0]; }
+  const StaticCacheVariant &variant(ContentEncoding encoding) const {
+    return variants[static_cast<size_t>(encoding)];
+  }
+  bool has_variant(ContentEncoding encoding) const {
+    return encoding == ContentEncoding::IDENTITY ||
+           !variant(encoding).body.empty();
+  }
+};
+
+// 分片LRU静态文件缓存：按字节预算淘汰，同一文件的并发未命中只读一次
+class StaticFileCache {
+public:
+  using EntryPtr = std::shared_ptr<const StaticCacheEntry>;
+
+  struct Stats {
+    size_t hits;
+    size_t misses;
+    size_t loads;     // 实际读文件次数
+    size_t coalesced; // 等待其他线程加载结果的未命中次数
+    size_t evictions;
+    size_t bytes;
+    size_t entries;
+  };
+
+private:
+  // 压缩版本的生成级别：启动预加载和打包不计耗时，请求路径上的加载
+  // 会让合并等待的请求一起阻塞，只用快速级别
+  enum class Compression : uint8_t {
+    FAST,
+    BEST,
+  };
+
+  struct Node {
+    std::string key;
+    EntryPtr entry; // 为空时记住的是"不存在、不是普通文件或太大"
+    size_t charge;  // 计入预算的字节数
+    time_t recorded = 0; // entry为空时的记录时间，过期后重新读文件确认
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::list<Node> lru; // 表头为最近使用
+    // 键指向链表节点内的字符串，节点不会移动，命中时不用构造std::string
+    std::unordered_map<std::string_view, std::list<Node>::iterator> index;
+    std::unordered_map<std::string, std::shared_future<EntryPtr>> loading;
+    size_t bytes = 0;
+  };
+
+  std::string root_;
+  size_t shard_budget_;
+  Shard shards_[STATIC_CACHE_SHARDS];
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+  std::atomic<size_t> loads_{0};
+  std::atomic<size_t> coalesced_{0};
+  std::atomic<size_t> evictions_{0};
+
+  Shard &shard_for(std::string_view path);
+  // 距上次确认超过时限时重新stat，同一条目同一时刻只有一个线程检查
+  bool is_fresh(const StaticCacheEntry &entry, std::string_view path,
+                time_t now) const;
+  // 读文件并生成条目，文件不存在、不是普通文件或超过max_size时返回nullptr
+  EntryPtr load(const std::string &path, size_t max_size,
+                Compression compression) const;
+  // 由已读入的内容生成条目，load和预加载共用
+  EntryPtr build_entry(const std::string &path, std::string body,
+                       int64_t mtime, Compression compression) const;
+  // 生成或读取压缩版本（调用方之后统一生成头部）
+  void load_variants(const std::string &full_path, int64_t mtime,
+                     Compression compression, StaticCacheEntry &entry) const;
+  // 调用方持有分片锁；entry为空时记住读不到（或不缓存）的结果
+  void insert_locked(Shard &shard, const std::string &path, EntryPtr entry);
+  void erase_locked(Shard &shard, std::string_view path);
+
+public:
+  StaticFileCache(std::string root, size_t budget);
+
+  static StaticFileCache &instance();
+
+  // path为规范化路径；返回nullptr时调用方直接读文件（由它给出404等响应）
+  // 不存在或太大的结果也记住，STATIC_CACHE_REVALIDATE_SECONDS内不再碰文件
+  EntryPtr get(std::string_view path);
+
+  // 只查缓存不读文件，没有新鲜的条目时返回nullptr：由事件循环驱动时
+  // 调用方在环上打开并读入文件，再用fill放入缓存
+  EntryPtr find(std::string_view path);
+
+  // 由在环上读入的内容生成条目（快速压缩级别）并放入缓存，
+  // 内容超过STATIC_CACHE_MAX_ENTRY时不缓存，返回nullptr
+  EntryPtr fill(const std::string &path, std::string body, int64_t mtime);
+
+  // 条目在缓存中且不到重新stat的时候：紧接着的get不会碰文件系统
+  // （除非期间被淘汰），分发器据此判断请求能否在事件循环线程处理
+  bool resident(std::string_view path);
+
+  // 启动时遍历根目录把文件载入缓存（同时生成压缩版本），返回载入的文件数
+  size_t preload();
+
+  const std::string &root() const { return root_; }
+  // 总字节预算（各分片预算之和）
+  size_t budget() const { return shard_budget_ * STATIC_CACHE_SHARDS; }
+
+  // 根目录下的普通文件（跳过预压缩的.gz/.br），规范化路径
+  std::vector<std::string> list_files() const;
+
+  // 读文件生成条目但不放入缓存，不限大小（打包静态归档用）
+  EntryPtr read_entry(const std::string &path) const {
+    return load(path, SIZE_MAX, Compression::BEST);
+  }
+
+  // 由别处读入的文件内容生成条目并放入缓存（环上批量预加载用），
+  // 内容超过STATIC_CACHE_MAX_ENTRY时不缓存，返回false
+  bool insert(const std::string &path, std::string body, int64_t mtime);
+
+  Stats stats();
+  void clear();
+};
@@ -0,0 +1,72 @@
+#pragma once
+// C系统头文件
+#include <sys/inotify.h>
+
+// C++标准库头文件
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 静态路径索引专用配置
+// 各级目录监视的事件：目录项增删改名，以及目录自身被删除或移走
+#define STATIC_INDEX_WATCH_MASK                                                \
+  (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF |      \
+   IN_MOVE_SELF | IN_ONLYDIR)
+
+// 静态根目录下已有文件的索引：启动时遍历建立，inotify监视各级目录保持最新
+// 路径不在索引中时文件一定不存在，直接回复404，不再open/stat
+// 查找只比较路径哈希（带计数，删除不会误伤同哈希的路径），哈希碰撞只会让
+// 请求照常交给文件系统判断；新建的文件在inotify事件处理前的短暂窗口内仍是404
+class StaticPathIndex {
+private:
+  std::string root_;
+  mutable std::shared_mutex mutex_;
+  bool enabled_;
+  std::unordered_map<uint64_t, uint32_t> hashes_; // 路径哈希 -> 路径数
+  // 以下只在建立索引和处理inotify事件时使用（持有写锁）
+  std::set<std::string> paths_;               // 已知文件的规范化路径
+  std::unordered_map<int, std::string> dirs_; // 监视描述符 -> 目录（根为空串）
+  int inotify_fd_;
+  bool incomplete_; // 索引无法覆盖全部文件（目录符号链接、监视失败）
+
+  static uint64_t hash(std::string_view path);
+  // 调用方持有写锁
+  void add_locked(const std::string &path);
+  void remove_locked(const std::string &path);
+  // 目录被删除或移走：摘除其下的文件和监视
+  void remove_dir_locked(const std::string &dir);
+  // 先监视再列目录，两者之间新建的文件不会漏掉
+  void scan_locked(const std::string &dir);
+  void rebuild_locked();
+
+public:
+  explicit StaticPathIndex(std::string root);
+  ~StaticPathIndex();
+
+  StaticPathIndex(const StaticPathIndex &) = delete;
+  StaticPathIndex &operator=(const StaticPathIndex &) = delete;
+
+  static StaticPathIndex &instance();
+
+  // 遍历根目录建立索引并监视各级目录，返回文件数
+  // inotify不可用或根目录下有目录符号链接时不启用，may_exist总是true
+  size_t build();
+
+  // path为规范化路径；返回false表示文件一定不存在
+  bool may_exist(std::string_view path) const;
+
+  // 事件循环在环上读inotify描述符，读的结果交给handle_watch_events，
+  // 返回索引增删的路径数；读出错时停用索引
+  int inotify_fd() const { return inotify_fd_; }
+  size_t handle_watch_events(const char *events, int result);
+
+  // 不再能收到事件时停用，之后may_exist总是true
+  void disable();
+
+  bool enabled() const;
+  size_t size() const;
+};
@@ -19,6 +19,14 @@ public:
   // 处理任务
   virtual void handle(ContextType *context) = 0;
 
+  // 报文完整后判断能否在事件循环线程直接处理（不阻塞），默认交给线程池
+  virtual bool can_run_inline(ContextType *context) {
+    (void)context;
+    return false;
+  }
+  // 在事件循环线程处理，默认同handle
+  virtual void handle_inline(ContextType *context) { handle(context); }
+
   // 获取处理器名称
   virtual TaskType get_name() const = 0;
 };
@@ -35,12 +43,42 @@ public:
     return HttpTask::is_http_parse_complete(context);
   }
 
-  void handle(ContextType *context) override {
-    HttpTask task;
-    task.handle_message(context);
+  bool can_run_inline(ContextType *context) override {
+    return HttpTask::can_run_inline(context);
   }
 
+  void handle(ContextType *context) override { run(context, false); }
+
+  void handle_inline(ContextType *context) override { run(context, true); }
+
   TaskType get_name() const override { return TaskType::HTTP; }
+
+private:
+  // 流水线：依次处理读缓冲区中所有完整请求，响应按顺序追加到写缓冲区，
+  // 由分发器回调合并成一次写出；inline_only时遇到会阻塞的请求就停下，
+  // 它留在读缓冲区，等前面的响应写完后重新分发给线程池
+  void run(ContextType *context, bool inline_only) {
+    size_t handled = 0;
+    do {
+      {
+        HttpTask task(context->arena.resource());
+        task.handle_message(context);
+      }
+      // 流式响应的数据源还在分配区里，等写完成事件拉取完后再回收
+      if (context->response_stream.active() &&
+          !context->response_stream.finished()) {
+        break;
+      }
+      // 响应已写入写缓冲区，本次请求的分配区可以整体回收
+      context->finish_response_stream();
+      // 文件在环上打开或读取，后续请求等事件循环完成后继续
+      if (context->file_op.pending() || context->file_stream.active()) {
+        break;
+      }
+    } while (++handled < HTTP_PIPELINE_MAX_REQUESTS &&
+             HttpTask::has_pipelined_request(context) &&
+             (!inline_only || HttpTask::can_run_inline(context)));
+  }
 };
 
 // 默认的文件处理器
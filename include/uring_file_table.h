@@ -0,0 +1,81 @@
+#pragma once
+// C系统头文件
+#include <liburing.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+// C++标准库头文件
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 项目头文件
+#include "uring_types.h"
+
+// 文件描述符缓存专用配置
+#define URING_FILE_TABLE_SIZE 64 // 缓存的打开文件数，也是注册的固定文件表大小
+#define URING_INOTIFY_BUFFER_SIZE 4096 // 一次从inotify读出的事件缓冲区大小
+// 被监视文件发生这些变化时缓存项失效（unlink会改变链接数，触发IN_ATTRIB）
+#define URING_FILE_WATCH_MASK                                                  \
+  (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF)
+
+// 热点静态文件的打开描述符缓存：按路径查找，描述符同时注册进环的固定文件表，
+// 文件流用IOSQE_FIXED_FILE按槽位读；inotify描述符也在环上读，文件变化时失效
+// 只在事件循环线程使用，不加锁
+class UringFileTable {
+private:
+  struct Slot {
+    std::string path;
+    int fd = -1;
+    int wd = -1;       // inotify监视描述符
+    struct statx stx;  // 打开时的元数据，命中时代替STATX
+    unsigned refs = 0; // 正在使用的连接数，为0时才能淘汰或关闭
+    uint64_t last_used = 0;
+    bool stale = false; // 已失效，等引用释放后关闭
+  };
+
+  struct io_uring *ring_;
+  bool registered_; // 固定文件表是否注册成功，失败时仍缓存描述符但不用固定文件
+  int inotify_fd_;
+  std::vector<Slot> slots_;
+  std::unordered_map<std::string, int> index_; // 路径 -> 槽位（不含已失效的）
+  std::unordered_map<int, int> watches_;       // inotify监视描述符 -> 槽位
+  uint64_t clock_;
+  alignas(struct inotify_event) char events_[URING_INOTIFY_BUFFER_SIZE];
+
+  // 从索引中摘除，之后的查找不再命中
+  void invalidate(int slot);
+  // 引用已释放：关闭描述符并清空固定文件表中的槽位
+  void close_slot(int slot);
+
+public:
+  explicit UringFileTable(struct io_uring *ring);
+  ~UringFileTable();
+
+  UringFileTable(const UringFileTable &) = delete;
+  UringFileTable &operator=(const UringFileTable &) = delete;
+
+  // 注册稀疏固定文件表并创建inotify描述符
+  bool init();
+
+  // 命中时把缓存的描述符和元数据交给连接（借用，不由连接关闭），状态为READY
+  bool lookup(UringConnectionInfo *conn);
+
+  // OPENAT+STATX完成后尝试缓存：确认打开的就是STATX看到的文件（inode和
+  // mtime一致）才收下，成功时连接改为借用缓存中的描述符
+  bool adopt(UringConnectionInfo *conn);
+
+  // 连接不再使用借用的描述符（文件流已读完、请求没有用到或连接关闭）
+  void release(UringConnectionInfo *conn);
+
+  // 准备读inotify事件的SQE，完成事件的user_data为本对象
+  bool prep_watch_read(struct io_uring_sqe *sqe);
+  // 处理读到的inotify事件，返回失效的缓存项数
+  size_t handle_watch_events(int result);
+
+  int inotify_fd() const { return inotify_fd_; }
+  bool fixed_files() const { return registered_; }
+  size_t size() const { return index_.size(); }
+};
@@ -0,0 +1,97 @@
+#pragma once
+// C系统头文件
+#include <liburing.h>
+#include <sys/stat.h>
+
+// C++标准库头文件
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 项目头文件
+#include "static_file_cache.h"
+
+// 启动预加载专用配置
+#define URING_PRELOAD_QUEUE_DEPTH 256 // 预加载环的深度，同时在读的文件数为其一半
+#define URING_PRELOAD_PROGRESS 100    // 每读完多少个文件打印一次进度
+
+// 启动时批量预加载静态文件：在独立的环上为一批文件同时提交链接的
+// OPENAT+STATX，之后READ整个文件再CLOSE，一次提交和等待处理整批完成事件；
+// 读完的内容由多个线程生成条目（压缩版本）放入缓存；读入的总字节数不超过
+// 缓存预算，放不下的文件留给请求路径按需加载
+// 在监听开始前调用，只在调用线程使用
+class UringPreloader {
+public:
+  struct Stats {
+    size_t files;   // 根目录下的文件数
+    size_t loaded;  // 放入缓存的文件数
+    size_t bytes;   // 读入的字节数
+    size_t skipped; // 打不开、不是普通文件、超过缓存上限或预算已满的文件数
+    size_t submits; // 提交批次数
+    double read_ms; // 读文件阶段耗时
+    double total_ms;
+  };
+
+private:
+  enum class JobState : uint8_t {
+    IDLE,
+    OPENING, // OPENAT和STATX已提交
+    READING,
+    CLOSING,
+  };
+
+  // 一个正在读的文件，完成事件的user_data指向它
+  struct Job {
+    JobState state = JobState::IDLE;
+    std::string path; // 规范化路径
+    std::string full_path;
+    int fd = -1; // CLOSE完成后才置为-1
+    int stat_result = 0;
+    struct statx stx;
+    unsigned outstanding = 0; // OPENAT+STATX还没到达的完成事件数
+    std::string body;
+    size_t offset = 0; // 已读入的字节数
+  };
+
+  // 读完的文件，等待生成条目
+  struct Loaded {
+    std::string path;
+    std::string body;
+    int64_t mtime;
+  };
+
+  StaticFileCache &cache_;
+  struct io_uring ring_;
+  bool initialized_;
+  std::vector<Job> jobs_;
+  std::vector<Loaded> loaded_;
+  size_t reserved_; // 已读入和正在读的字节数，不超过缓存预算
+  Stats stats_;
+
+  void start_open(Job &job, const std::string &path);
+  // 处理一个完成事件，文件处理完（job回到IDLE）时返回true
+  bool handle_completion(Job &job, int result);
+  void prep_read(Job &job);
+  void prep_close(Job &job);
+  // 提交失败后收尾：等已提交的inflight个请求完成，关闭打开的文件并拆除环
+  void abandon(size_t inflight);
+  // 多线程生成条目并放入缓存，返回放入的文件数
+  size_t build_entries();
+
+public:
+  explicit UringPreloader(StaticFileCache &cache);
+  ~UringPreloader();
+
+  UringPreloader(const UringPreloader &) = delete;
+  UringPreloader &operator=(const UringPreloader &) = delete;
+
+  // 创建预加载环；失败时调用方改用StaticFileCache::preload
+  bool init();
+
+  // 读入根目录下的全部文件并放入缓存，返回放入的文件数；提交失败时
+  // 已读完的文件照常放入缓存，环随之拆除，不能再次调用
+  size_t run();
+
+  const Stats &stats() const { return stats_; }
+};
@@ -8,6 +8,7 @@
 
 // C++标准库头文件
 #include <atomic>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
@@ -16,8 +17,10 @@
 #include "dispatcher.h"
 #include "memery_pool.h"
 #include "pthread_pool.h"
+#include "static_path_index.h"
 #include "taskHander.h"
 #include "tcp.h"
+#include "uring_file_table.h"
 #include "uring_types.h"
 
 // io_uring模块专用配置
@@ -33,24 +36,48 @@ private:
   bool initialize_uring();
   bool set_accept_event(int listen_fd);
   bool set_read_event(UringConnectionInfo *conn);
+  bool set_extra_read_event(UringConnectionInfo *conn);
   bool set_write_event(UringConnectionInfo *conn);
   bool set_close_event(UringConnectionInfo *conn);
+  bool set_shutdown_event(UringConnectionInfo *conn);
+  bool set_file_close_event(UringConnectionInfo *conn);
+  bool set_watch_read_event();
+  bool set_path_watch_read_event();
+  bool set_wakeup_read_event();
   void process_completion_events();
   void handle_completion_event(UringConnectionInfo *conn, int result);
   void handle_accept_event(UringConnectionInfo *conn, int result);
-  void handle_read_event(UringConnectionInfo *conn, size_t result);
+  void handle_read_event(UringConnectionInfo *conn, int result);
   void handle_write_event(UringConnectionInfo *conn, int result);
   void handle_close_event(UringConnectionInfo *conn);
+  void handle_file_open_event(UringConnectionInfo *conn, int result);
+  void handle_watch_event(int result);
+  void handle_path_watch_event(int result);
+  void handle_wakeup_event(int result);
   void process_main_thread_tasks();
+  void run_maintenance();
   std::shared_ptr<io_uring> _ring;
   std::unique_ptr<TcpListener> _tcp_listener;
   std::shared_ptr<LayerMemoryPool> _memory_pool;
   std::atomic<bool> _running;
 
+  // 周期性维护（内存回收等），由事件循环驱动
+  MemoryTrimPolicy _trim_policy;
+  std::chrono::steady_clock::time_point _last_maintenance;
+
   // 主线程任务队列和线程池
   std::shared_ptr<MainThreadTaskQueue> _main_queue;
   std::shared_ptr<ThreadPool> _thread_pool;
   std::shared_ptr<TaskDispatcher> _task_dispatcher;
+  // 主线程队列的eventfd在环上读入这里，完成事件的user_data为队列
+  uint64_t _wakeup_value;
+
+  // 热点文件的打开描述符缓存（注册为固定文件），inotify不可用时为空
+  std::shared_ptr<UringFileTable> _file_table;
+
+  // 静态路径索引的inotify事件在环上读入这里，索引未启用时指针为空
+  StaticPathIndex *_path_index;
+  alignas(struct inotify_event) char _path_events[URING_INOTIFY_BUFFER_SIZE];
 
 public:
   // 构造函数和析构函数声明
@@ -60,6 +87,9 @@ public:
   // 公共方法声明
   void run();
   void stop();
+  void set_trim_policy(const MemoryTrimPolicy &policy) {
+    _trim_policy = policy;
+  }
 
   // 禁用拷贝构造和赋值
   IoUringServer(const IoUringServer &) = delete;
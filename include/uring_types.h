@@ -2,20 +2,34 @@
 // C系统头文件
 #include <liburing.h>
 #include <liburing/io_uring.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 // C++标准库头文件
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <cstring>
 #include <functional>
+#include <iostream>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <stdexcept>
 #include <string>
 #include <time.h>
 #include <vector>
+
+// 项目头文件
+#include "http_parser.h"
+#include "http_range.h"
+#include "http_stream.h"
+#include "request_arena.h"
 // io_uring模块专用配置
 #define URING_MAX_QUEUE 1024
 #define URING_thread_MAX_QUEUE 1024
@@ -25,20 +39,20 @@
 #define TCP_DEFAULT_PORT 2025
 #define MAX_CACHE_SIZE (1024 * 1024)
 #define MIN_BLOCK_SIZE (4 * 1024)
+#define MEMORY_TRIM_INTERVAL_MS 1000                 // 回收检查周期
+#define MEMORY_HIGH_WATERMARK (48UL * 1024 * 1024)  // 超过开始回收
+#define MEMORY_LOW_WATERMARK (24UL * 1024 * 1024)   // 回收到此为止
+#define MEMORY_CONNECTION_SLAB_RESERVE 2            // 保留的空连接slab
+#define MEMORY_SIZE_CLASS_SLAB_RESERVE 1            // 每级保留的空小对象slab
+#define HTTP_MAX_KEEPALIVE_REQUESTS 1000            // 单个连接最多处理的请求数
 struct UringConnectionInfo;
 // 连接状态枚举
 enum class UringConnectionState {
   ACCEPT, // 等待新的连接
   READ,   // 等待读取数据
   WRITE,  // 等待写入数据
-  CLOSE   // 等待关闭连接
-};
-// http报文解析枚举状态
-enum class ParseResult {
-  COMPLETE,
-  NEEED_MORE_DATA,
-  INVALID_FORMAT,
-  CHUNKED_UNSUPPORTED,
+  CLOSE,  // 等待关闭连接
+  FILE_OPEN // 等待静态文件在环上打开（OPENAT+STATX）
 };
 enum class TaskType {
   HTTP,
@@ -133,6 +147,43 @@ public:
     _tail.store(0, std::memory_order_release);
   }
 
+  // 移除可读数据中[offset, offset+length)这一段，后面的数据前移
+  // 要求可读数据连续（见compact），用于丢弃已经流式交付的请求体
+  void erase(size_t offset, size_t length) {
+    if (length == 0) {
+      return;
+    }
+    size_t head = _head.load(std::memory_order_acquire);
+    size_t readable = get_readable_size();
+    char *start = _buffer.data() + head;
+    std::memmove(start + offset, start + offset + length,
+                 readable - offset - length);
+    _tail.store((head + readable - length) % _capacity,
+                std::memory_order_release);
+  }
+
+  // 读之前整理缓冲区：保证可读数据始终连续，报文可以直接按指针+长度解析
+  // 已读空时直接复位；数据绕回或尾部空间不足一半时把数据搬到开头
+  void compact() {
+    size_t head = _head.load(std::memory_order_acquire);
+    size_t tail = _tail.load(std::memory_order_acquire);
+    if (head == tail) {
+      clear();
+      return;
+    }
+    if (head == 0 || (tail > head && _capacity - tail >= _capacity / 2)) {
+      return;
+    }
+    size_t readable = get_readable_size();
+    if (tail > head || tail == 0) {
+      std::memmove(_buffer.data(), _buffer.data() + head, readable);
+    } else {
+      std::rotate(_buffer.begin(), _buffer.begin() + head, _buffer.end());
+    }
+    _head.store(0, std::memory_order_release);
+    _tail.store(readable, std::memory_order_release);
+  }
+
   size_t get_capacity() const { return _capacity; }
 };
 
@@ -158,62 +209,271 @@ struct MainThreadTask {
   }
 };
 
-// 主线程任务队列（用于线程池回调）
+// 主线程任务队列（用于线程池回调）：工作线程处理完请求后，把后续的环操作
+// 交回事件循环线程。槽位预先构造成环形数组，入队出队不分配内存；开启唤醒后
+// 空队列入队时写eventfd，事件循环在环上读它，不用等到超时才处理
 class MainThreadTaskQueue {
 private:
-  std::queue<MainThreadTask> _tasks;
+  std::vector<MainThreadTask> _tasks; // 环形槽位，容量URING_MAX_QUEUE
+  size_t _head = 0;
+  size_t _count = 0;
   std::mutex _mutex;
   std::condition_variable _condition;
   std::atomic<bool> _running{true};
+  int _event_fd = -1; // 唤醒事件循环的eventfd，未开启时为-1
 
 public:
-  // 添加任务到主线程队列
+  MainThreadTaskQueue()
+      : _tasks(URING_MAX_QUEUE, MainThreadTask(nullptr, nullptr)) {}
+  ~MainThreadTaskQueue() {
+    if (_event_fd >= 0) {
+      close(_event_fd);
+    }
+  }
+  MainThreadTaskQueue(const MainThreadTaskQueue &) = delete;
+  MainThreadTaskQueue &operator=(const MainThreadTaskQueue &) = delete;
+
+  // 创建唤醒用的eventfd，由事件循环在环上读；不能设O_NONBLOCK，
+  // 否则环上的READ没有数据时直接以-EAGAIN完成，而不是等到有数据
+  bool enable_wakeup() {
+    if (_event_fd < 0) {
+      _event_fd = eventfd(0, EFD_CLOEXEC);
+    }
+    return _event_fd >= 0;
+  }
+  int wakeup_fd() const { return _event_fd; }
+
+  // 添加任务到主线程队列，队列满或已停止时返回false
   bool push_task(UringConnectionInfo *conn, TaskCallback callback,
                  TaskPriority priority = TaskPriority::NORMAL) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (_tasks.size() >= URING_MAX_QUEUE) {
-      return false;
+    bool was_empty;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_running || _count == _tasks.size()) {
+        return false;
+      }
+      MainThreadTask &slot = _tasks[(_head + _count) % _tasks.size()];
+      slot.conn = conn;
+      slot.callback = std::move(callback);
+      slot.priority = priority;
+      was_empty = _count++ == 0;
     }
-    _tasks.emplace(conn, callback, priority);
     _condition.notify_one();
+    // 队列非空时事件循环一定会继续取，只有从空变为非空才需要唤醒
+    if (was_empty && _event_fd >= 0) {
+      uint64_t one = 1;
+      if (write(_event_fd, &one, sizeof(one)) != sizeof(one)) {
+        std::cerr << "写主线程队列eventfd失败" << std::endl;
+      }
+    }
     return true;
   }
 
   // 获取任务（阻塞）
   MainThreadTask pop_task() {
     std::unique_lock<std::mutex> lock(_mutex);
-    _condition.wait(lock, [this]() { return !_running || !_tasks.empty(); });
+    _condition.wait(lock, [this]() { return !_running || _count > 0; });
 
-    if (!_running && _tasks.empty()) {
+    if (!_running && _count == 0) {
       throw std::runtime_error("Task queue stopped");
     }
 
-    MainThreadTask task = std::move(_tasks.front());
-    _tasks.pop();
+    MainThreadTask task(nullptr, nullptr);
+    take_front(task);
     return task;
   }
 
   // 非阻塞获取任务
   bool try_pop_task(MainThreadTask &task) {
     std::lock_guard<std::mutex> lock(_mutex);
-    if (_tasks.empty())
+    if (_count == 0)
       return false;
 
-    task = std::move(_tasks.front());
-    _tasks.pop();
+    take_front(task);
     return true;
   }
 
-  // 停止队列
+  // 停止队列：之后的入队都失败，等待中的工作线程不再重试
   void stop() {
     _running = false;
     _condition.notify_all();
   }
+  bool running() const { return _running; }
 
   // 获取队列大小
   size_t size() {
     std::lock_guard<std::mutex> lock(_mutex);
-    return _tasks.size();
+    return _count;
+  }
+
+private:
+  // 调用方持锁
+  void take_front(MainThreadTask &task) {
+    MainThreadTask &slot = _tasks[_head];
+    task.conn = slot.conn;
+    task.callback = std::move(slot.callback);
+    task.priority = slot.priority;
+    slot.conn = nullptr;
+    slot.callback = nullptr;
+    _head = (_head + 1) % _tasks.size();
+    _count--;
+  }
+};
+
+// 静态文件打开的阶段：工作线程登记路径后暂停该请求，事件循环提交链接的
+// OPENAT+STATX，两个完成事件到齐后把同一个请求重新交给工作线程；
+// 要填充内容缓存的小文件先在环上整个读入再交回
+enum class UringFileOpState : uint8_t {
+  IDLE,
+  REQUESTED, // 已登记，等写缓冲区中之前的响应写完后提交
+  OPENING,   // OPENAT和STATX已提交
+  READING,   // 整个文件的READ已提交
+  READY,     // 结果就绪，重新处理请求时取走
+};
+
+struct UringFileOp {
+  UringFileOpState state = UringFileOpState::IDLE;
+  std::string path; // 完整路径，完成前保持不变，容量跨请求复用
+  int fd = -1;      // OPENAT的结果，失败时为-errno
+  int stat_result = 0; // STATX的结果
+  struct statx stx;
+  unsigned outstanding = 0; // 还没到达的完成事件数
+  // 描述符借自文件描述符缓存时为其槽位（连接持有一个引用，由缓存释放），
+  // 否则为-1；reset不清除，借用一直持续到缓存的release
+  int slot = -1;
+  bool fixed = false; // 槽位已注册进环的固定文件表
+  // 大于0时，打开的普通文件不超过此大小就在环上整个读入body
+  size_t body_limit = 0;
+  std::string body;     // 在环上读入的文件内容，重新处理请求时取走
+  size_t body_read = 0; // 已读入的字节数
+  bool body_ready = false;
+
+  bool borrowed() const { return slot >= 0; }
+
+  bool pending() const {
+    return state == UringFileOpState::REQUESTED ||
+           state == UringFileOpState::OPENING ||
+           state == UringFileOpState::READING;
+  }
+
+  // 打开成功且文件可以整个读入
+  bool wants_body() const {
+    return body_limit > 0 && fd >= 0 && stat_result == 0 &&
+           S_ISREG(stx.stx_mode) && stx.stx_size <= body_limit;
+  }
+
+  // 开始读入整个文件，空文件直接就绪，返回是否需要提交READ
+  bool start_body() {
+    body.resize(stx.stx_size);
+    body_read = 0;
+    body_ready = body.empty();
+    state = body_ready ? UringFileOpState::READY : UringFileOpState::READING;
+    return !body_ready;
+  }
+
+  // 一次READ完成，还要接着读时返回false；读失败时放弃内容，
+  // 请求改用打开的描述符流式发送；文件变短时保留已读的部分
+  bool finish_body_read(int result) {
+    if (result > 0) {
+      body_read += result;
+      if (body_read < body.size()) {
+        return false;
+      }
+    }
+    if (result < 0) {
+      body.clear();
+    } else {
+      body.resize(body_read);
+      body_ready = true;
+    }
+    state = UringFileOpState::READY;
+    return true;
+  }
+
+  // 链接的请求按提交顺序完成：先OPENAT后STATX，全部到齐时返回true
+  bool complete(int result) {
+    if (outstanding == 2) {
+      fd = result;
+    } else {
+      stat_result = result;
+    }
+    if (--outstanding > 0) {
+      return false;
+    }
+    state = UringFileOpState::READY;
+    return true;
+  }
+
+  // 取走打开的文件描述符（可能为负），之后由调用方负责关闭；
+  // borrowed()时描述符属于缓存，调用方不能关闭
+  int take_fd() {
+    int result = fd;
+    fd = -1;
+    state = UringFileOpState::IDLE;
+    return result;
+  }
+
+  void reset() {
+    if (fd >= 0 && !borrowed()) {
+      ::close(fd);
+    }
+    fd = -1;
+    outstanding = 0;
+    body_limit = 0;
+    body.clear();
+    body_read = 0;
+    body_ready = false;
+    state = UringFileOpState::IDLE;
+  }
+};
+
+// 在环上读取的文件响应体：每段READ读入写缓冲区尾部，链接的WRITE随后写出
+struct UringFileStream {
+  int fd = -1;
+  uint64_t offset = 0;  // 下一次READ的文件偏移
+  size_t remaining = 0; // 还没提交READ的字节数
+  int slot = -1;        // 描述符借自文件描述符缓存时的槽位，不由文件流关闭
+  bool fixed = false;   // READ按固定文件槽位提交（IOSQE_FIXED_FILE）
+  HttpRangeParts parts; // 多段范围响应各段之前的分隔头部
+
+  bool active() const { return fd >= 0; }
+  bool borrowed() const { return slot >= 0; }
+
+  // 所有数据段都已提交READ，分隔头部也都已写入
+  bool finished() const { return remaining == 0 && parts.done(); }
+
+  // fd的所有权交给文件流
+  void start(int file_fd, uint64_t from, size_t length) {
+    fd = file_fd;
+    offset = from;
+    remaining = length;
+    slot = -1;
+    fixed = false;
+    parts.clear();
+  }
+
+  // 多段范围响应：逐段按偏移读，每段之前写入分隔头部
+  void start_parts(int file_fd, HttpMime mime, size_t size,
+                   const HttpByteRange *ranges, size_t count) {
+    start(file_fd, 0, 0);
+    parts.start(mime, size, ranges, count);
+  }
+
+  // 描述符借自文件描述符缓存：只读不关，有固定槽位时按槽位读
+  void borrow_from(const UringFileOp &op) {
+    slot = op.slot;
+    fixed = op.fixed;
+  }
+
+  void close() {
+    if (fd >= 0 && !borrowed()) {
+      ::close(fd);
+    }
+    fd = -1;
+    remaining = 0;
+    slot = -1;
+    fixed = false;
+    parts.clear();
   }
 };
 
@@ -228,8 +488,23 @@ struct UringConnectionInfo {
   size_t bytes_NO_read;         // 还需要读的长度
   TaskType task_type;           //任务类型
   ParseResult parse_result;     // http报文解析状态
+  HttpParser parser;            // 增量解析器，跨多次读取保存解析位置
   char *extra_buffer; // 额外缓冲区，用于存储不完整的http报文
   bool extra_buffer_in_use; // 额外缓冲区是否在使用中
+  size_t extra_buffer_filled; // 额外缓冲区已读入的字节数
+  RequestArena arena; // 请求级分配区，每次响应写出后重置
+  HttpBodySink *body_sink; // 当前chunked请求体的接收端（位于请求分配区）
+  HttpResponseStream response_stream; // 正在进行的流式响应
+  // 写缓冲区之后待写出的外部数据（缓存条目的响应体），零拷贝直接写出
+  std::string_view output_segment;
+  std::shared_ptr<const void> output_owner; // 写完前持有外部数据的所有者
+  struct iovec write_iov[2]; // 写缓冲区和外部数据一起写出时的iovec
+  bool ring_file_io; // 由事件循环驱动时文件在环上打开和读取，否则工作线程直接读
+  UringFileOp file_op;         // 正在环上打开的静态文件
+  UringFileStream file_stream; // 正在环上读取的文件响应体
+  bool keep_alive;        // 响应写完后是否保持连接
+  size_t requests_served; // 本连接已处理的请求数
+  time_t last_active_time; // 最近一次读写完成的时间
   std::shared_ptr<MainThreadTaskQueue> _main_queue; // 主线程任务队列引用
 
   UringConnectionInfo()
@@ -237,7 +512,230 @@ struct UringConnectionInfo {
         write_buffer(URING_BUFFER_SIZE), state(UringConnectionState::ACCEPT),
         bytes_NO_read(0), task_type(TaskType::NOKNOW),
         parse_result(ParseResult::NEEED_MORE_DATA), extra_buffer(nullptr),
-        extra_buffer_in_use(false), last_active_time(0), _main_queue(nullptr) {}
+        extra_buffer_in_use(false), extra_buffer_filled(0), body_sink(nullptr),
+        ring_file_io(false), keep_alive(true), requests_served(0), last_active_time(0),
+        _main_queue(nullptr) {}
+
+  // 连接对象从池中复用时，清掉上一个连接留下的状态
+  void reset() {
+    read_buffer.clear();
+    write_buffer.clear();
+    bytes_NO_read = 0;
+    task_type = TaskType::NOKNOW;
+    parse_result = ParseResult::NEEED_MORE_DATA;
+    parser.reset();
+    extra_buffer_in_use = false;
+    extra_buffer_filled = 0;
+    close_body_sink();
+    response_stream.close();
+    clear_output_segment();
+    file_op.reset();
+    file_stream.close();
+    arena.reset();
+    keep_alive = true;
+    requests_served = 0;
+    last_active_time = time(nullptr);
+  }
+
+  // 流式响应：写缓冲区腾出空间后继续拉取响应体，返回本次写入的字节数
+  size_t pump_response_stream() {
+    write_buffer.compact();
+    size_t written = response_stream.pump(write_buffer.get_write_tail(),
+                                          write_buffer.get_writable_size());
+    write_buffer.write_data(written);
+    if (response_stream.truncated()) {
+      keep_alive = false;
+    }
+    return written;
+  }
+
+  // 流式响应结束：销毁数据源，回收这个请求的分配区
+  void finish_response_stream() {
+    response_stream.close();
+    arena.reset();
+  }
+
+  // 追加外部数据：排在写缓冲区现有内容之后写出，写完前由owner保证有效
+  void set_output_segment(std::shared_ptr<const void> owner,
+                          std::string_view data) {
+    output_owner = std::move(owner);
+    output_segment = data;
+  }
+
+  void clear_output_segment() {
+    output_segment = std::string_view();
+    output_owner.reset();
+  }
+
+  // 待写出的总字节数（写缓冲区+外部数据）
+  size_t pending_write_size() const {
+    return write_buffer.get_readable_size() + output_segment.size();
+  }
+
+  // 准备写SQE：有外部数据时用writev和写缓冲区中的响应头一次写出
+  void prep_write(struct io_uring_sqe *sqe) {
+    char *buffer = write_buffer.get_read_head();
+    size_t size = write_buffer.get_readable_size();
+    if (output_segment.empty()) {
+      io_uring_prep_write(sqe, fd, buffer, size, 0);
+      return;
+    }
+    unsigned count = 0;
+    if (size > 0) {
+      write_iov[count].iov_base = buffer;
+      write_iov[count].iov_len = size;
+      ++count;
+    }
+    write_iov[count].iov_base = const_cast<char *>(output_segment.data());
+    write_iov[count].iov_len = output_segment.size();
+    ++count;
+    io_uring_prep_writev(sqe, fd, write_iov, count, 0);
+  }
+
+  // 还有要写出的数据（含文件流中还没读入的部分）
+  bool has_output() const {
+    return pending_write_size() > 0 ||
+           (file_stream.active() && !file_stream.finished());
+  }
+
+  // 文件流下一段READ的长度：整理写缓冲区后按尾部连续空间计算，
+  // 剩余空间太小时返回0，先把已有内容写出；多段范围响应在每段之前
+  // 先把分隔头部写入写缓冲区
+  size_t next_file_chunk() {
+    if (!file_stream.active() || file_stream.finished()) {
+      return 0;
+    }
+    write_buffer.compact();
+    if (file_stream.remaining == 0) {
+      if (write_buffer.get_writable_size() < HTTP_RANGE_PART_HEADER_SIZE) {
+        return 0;
+      }
+      size_t written = 0;
+      HttpByteRange range;
+      if (file_stream.parts.next(write_buffer.get_write_tail(), written,
+                                 range)) {
+        file_stream.offset = range.first;
+        file_stream.remaining = range.length();
+      }
+      write_buffer.write_data(written);
+      if (file_stream.remaining == 0) {
+        return 0;
+      }
+    }
+    size_t size =
+        std::min(write_buffer.get_writable_size(), file_stream.remaining);
+    if (size < file_stream.remaining && size < HTTP_STREAM_MIN_SPACE) {
+      return 0;
+    }
+    return size;
+  }
+
+  // 为READ预留写缓冲区尾部的size字节，返回读入位置
+  char *commit_file_chunk(size_t size) {
+    char *out = write_buffer.get_write_tail();
+    write_buffer.write_data(size);
+    file_stream.offset += size;
+    file_stream.remaining -= size;
+    return out;
+  }
+
+  // 准备输出：文件流还有数据时先READ到写缓冲区尾部，链接的WRITE把已有内容
+  // 和读入的数据一起写出；READ读到的比预留的少（文件被截断）时链接的WRITE
+  // 以-ECANCELED完成，由写完成事件关闭连接。READ的完成事件不带连接指针
+  // 需要的sqe先一次确认够用，不会只放进带IO_LINK的READ而把后面无关的请求链上
+  bool prep_output(struct io_uring *ring) {
+    size_t chunk = next_file_chunk();
+    unsigned needed = chunk > 0 ? 2u : 1u;
+    if (io_uring_sq_space_left(ring) < needed) {
+      io_uring_submit(ring);
+      if (io_uring_sq_space_left(ring) < needed) {
+        return false;
+      }
+    }
+    if (chunk > 0) {
+      struct io_uring_sqe *read_sqe = io_uring_get_sqe(ring);
+      uint64_t offset = file_stream.offset;
+      int target = file_stream.fixed ? file_stream.slot : file_stream.fd;
+      io_uring_prep_read(read_sqe, target, commit_file_chunk(chunk), chunk,
+                         offset);
+      io_uring_sqe_set_data(read_sqe, nullptr);
+      read_sqe->flags |= IOSQE_IO_LINK;
+      if (file_stream.fixed) {
+        read_sqe->flags |= IOSQE_FIXED_FILE;
+      }
+    }
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (!sqe) {
+      return false;
+    }
+    prep_write(sqe);
+    io_uring_sqe_set_data(sqe, this);
+    state = UringConnectionState::WRITE;
+    return true;
+  }
+
+  // 登记在环上打开文件，请求暂停到结果就绪；body_limit大于0时
+  // 不超过此大小的普通文件同时整个读入（用来填充内容缓存）
+  void request_file_open(std::string_view full_path, size_t body_limit = 0) {
+    file_op.path.assign(full_path.data(), full_path.size());
+    file_op.fd = -1; // 仍借用的槽位由事件循环在查找前释放
+    file_op.stat_result = 0;
+    file_op.body_limit = body_limit;
+    file_op.body.clear();
+    file_op.body_ready = false;
+    file_op.state = UringFileOpState::REQUESTED;
+  }
+
+  // 准备链接的OPENAT+STATX：STATX按路径执行，紧跟在打开成功之后；
+  // 打开失败时STATX以-ECANCELED完成，两个完成事件都带连接指针
+  void prep_file_open(struct io_uring_sqe *open_sqe,
+                      struct io_uring_sqe *stat_sqe) {
+    io_uring_prep_openat(open_sqe, AT_FDCWD, file_op.path.c_str(),
+                         O_RDONLY | O_CLOEXEC, 0);
+    io_uring_sqe_set_data(open_sqe, this);
+    open_sqe->flags |= IOSQE_IO_LINK;
+    io_uring_prep_statx(stat_sqe, AT_FDCWD, file_op.path.c_str(), 0,
+                        STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_INO,
+                        &file_op.stx);
+    io_uring_sqe_set_data(stat_sqe, this);
+    file_op.outstanding = 2;
+    file_op.state = UringFileOpState::OPENING;
+    state = UringConnectionState::FILE_OPEN;
+  }
+
+  // 准备读入整个文件的（剩余部分）READ，完成事件带连接指针
+  void prep_file_body_read(struct io_uring_sqe *sqe) {
+    size_t done = file_op.body_read;
+    int target = file_op.fixed ? file_op.slot : file_op.fd;
+    io_uring_prep_read(sqe, target, file_op.body.data() + done,
+                       file_op.body.size() - done, done);
+    io_uring_sqe_set_data(sqe, this);
+    if (file_op.fixed) {
+      sqe->flags |= IOSQE_FIXED_FILE;
+    }
+    state = UringConnectionState::FILE_OPEN;
+  }
+
+  // 写完成：先消耗写缓冲区，剩余的部分属于外部数据
+  void consume_written(size_t written) {
+    size_t from_buffer = std::min(written, write_buffer.get_readable_size());
+    write_buffer.read_data(from_buffer);
+    written -= from_buffer;
+    if (written > 0) {
+      output_segment.remove_prefix(written);
+      if (output_segment.empty()) {
+        output_owner.reset();
+      }
+    }
+  }
+
+  // 销毁请求体接收端，内存随请求分配区一起回收
+  void close_body_sink() {
+    if (body_sink) {
+      body_sink->~HttpBodySink();
+      body_sink = nullptr;
+    }
+  }
 
   // 设置主线程队列
   void set_main_queue(std::shared_ptr<MainThreadTaskQueue> main_queue) {
@@ -0,0 +1,116 @@
+#pragma once
+// C++标准库头文件
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Chase-Lev工作窃取双端队列（按Lê等人的C11内存模型版本）：
+// 所有者在底部push/pop（LIFO，缓存更热），其他线程在顶部steal（FIFO）；
+// 只有队列剩最后一个元素时所有者和窃取者才需要CAS竞争
+// 元素是指针，槽位本身是原子量，窃取者读到旧值时CAS必然失败
+template <typename T> class WorkStealingDeque {
+private:
+  // 环形数组，容量为2的幂；扩容后旧数组保留到队列销毁，窃取者可能还在读
+  struct Array {
+    int64_t capacity;
+    std::unique_ptr<std::atomic<T *>[]> slots;
+
+    explicit Array(int64_t size)
+        : capacity(size), slots(new std::atomic<T *>[size]) {}
+
+    T *get(int64_t index) const {
+      return slots[index & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+    void put(int64_t index, T *value) {
+      slots[index & (capacity - 1)].store(value, std::memory_order_relaxed);
+    }
+  };
+
+  alignas(64) std::atomic<int64_t> top_;
+  alignas(64) std::atomic<int64_t> bottom_;
+  std::atomic<Array *> array_;
+  std::vector<std::unique_ptr<Array>> arrays_; // 只由所有者修改
+
+  Array *grow(Array *old, int64_t bottom, int64_t top) {
+    auto bigger = std::make_unique<Array>(old->capacity * 2);
+    for (int64_t i = top; i < bottom; ++i) {
+      bigger->put(i, old->get(i));
+    }
+    Array *result = bigger.get();
+    arrays_.push_back(std::move(bigger));
+    array_.store(result, std::memory_order_release);
+    return result;
+  }
+
+public:
+  // capacity须为2的幂，满了自动翻倍
+  explicit WorkStealingDeque(int64_t capacity = 256) : top_(0), bottom_(0) {
+    arrays_.push_back(std::make_unique<Array>(capacity));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  // 只由所有者调用
+  void push(T *value) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    Array *array = array_.load(std::memory_order_relaxed);
+    if (bottom - top > array->capacity - 1) {
+      array = grow(array, bottom, top);
+    }
+    array->put(bottom, value);
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+
+  // 只由所有者调用，空时返回nullptr
+  T *pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Array *array = array_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T *value = array->get(bottom);
+    if (top == bottom) {
+      // 最后一个元素：和窃取者竞争
+      if (!top_.compare_exchange_strong(top, top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        value = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return value;
+  }
+
+  // 任意线程调用；空或与其他线程竞争失败时返回nullptr
+  T *steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return nullptr;
+    }
+    T *value = array_.load(std::memory_order_acquire)->get(top);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return value;
+  }
+
+  // 近似值，只用于统计和判断是否有活可干
+  size_t size() const {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+  }
+  bool empty() const { return size() == 0; }
+};
@@ -3,6 +3,8 @@
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
 
 Buffer_BuddySystem::Buffer_BuddySystem(size_t pool_size, size_t min_block_size)
     : total_pool_size(pool_size), min_block_size(min_block_size) {
@@ -19,15 +21,18 @@ Buffer_BuddySystem::Buffer_BuddySystem(size_t pool_size, size_t min_block_size)
   // 初始化空闲链表数组
   free_lists.resize(max_order + 1, nullptr);
 
-  // 分配内存池
-  memory_pool = new char[total_pool_size];
-  if (!memory_pool) {
+  // 分配内存池（mmap按页对齐，空闲区可以madvise归还）
+  void *region = mmap(nullptr, total_pool_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
     throw std::bad_alloc();
   }
+  memory_pool = static_cast<char *>(region);
 
-  // 创建最大的块并加入空闲链表
+  // 创建最大的块并加入空闲链表（新映射的页尚未驻留）
   BuddyBlock *initial_block =
       new BuddyBlock(memory_pool, total_pool_size, max_order);
+  initial_block->purged = true;
   free_lists[max_order] = initial_block;
 
   std::cout << "伙伴系统初始化完成: 总大小=" << total_pool_size
@@ -47,9 +52,12 @@ Buffer_BuddySystem::~Buffer_BuddySystem() {
       current = next;
     }
   }
+  for (auto &entry : allocated_blocks) {
+    delete entry.second;
+  }
 
   // 释放内存池
-  delete[] memory_pool;
+  munmap(memory_pool, total_pool_size);
 }
 
 size_t Buffer_BuddySystem::calculate_order(size_t size) const {
@@ -101,7 +109,9 @@ char *Buffer_BuddySystem::allocate_buffer(size_t size) {
   BuddyBlock *block = free_lists[required_order];
   free_lists[required_order] = block->next;
   block->is_free = false;
+  block->purged = false;
   block->next = nullptr;
+  allocated_blocks[block->base_address] = block;
 
   // 清零分配的内存
   std::memset(block->base_address, 0, block->size);
@@ -126,6 +136,9 @@ void Buffer_BuddySystem::split_block(size_t order) {
   BuddyBlock *right_block =
       new BuddyBlock(block->base_address + new_size, new_size, new_order);
 
+  left_block->purged = block->purged;
+  right_block->purged = block->purged;
+
   // 设置伙伴关系
   left_block->buddy = right_block;
   right_block->buddy = left_block;
@@ -148,54 +161,64 @@ bool Buffer_BuddySystem::deallocate_buffer(char *ptr) {
     return false;
   }
 
-  // 查找对应的块（简化实现，实际应该维护分配块的映射）
-  // 这里我们遍历所有可能的块来查找
-  for (size_t order = 0; order <= max_order; ++order) {
-    size_t block_size = min_block_size * (1 << order);
-    BuddyBlock *current = free_lists[order];
-    BuddyBlock *prev = nullptr;
+  // 通过已分配块索引找到对应的块
+  auto it = allocated_blocks.find(ptr);
+  if (it == allocated_blocks.end()) {
+    return false;
+  }
+  BuddyBlock *block = it->second;
+  allocated_blocks.erase(it);
+
+  // 加入空闲链表并尝试合并
+  block->is_free = true;
+  block->next = free_lists[block->order];
+  free_lists[block->order] = block;
+  merge_buddies(block);
+  return true;
+}
 
-    while (current) {
-      if (!current->is_free && current->base_address == ptr) {
-        // 找到对应的块
-        current->is_free = true;
-
-        // 从当前位置移除
-        if (prev) {
-          prev->next = current->next;
-        } else {
-          free_lists[order] = current->next;
-        }
-
-        // 加入空闲链表并尝试合并
-        current->next = free_lists[order];
-        free_lists[order] = current;
-
-        // 尝试合并伙伴块
-        merge_buddies(current);
-        return true;
-      }
-      prev = current;
-      current = current->next;
+// 伙伴地址 = 块偏移 异或 块大小，在同级空闲链表中查找
+Buffer_BuddySystem::BuddyBlock *
+Buffer_BuddySystem::find_buddy(BuddyBlock *block) {
+  size_t offset = block->base_address - memory_pool;
+  size_t buddy_offset = offset ^ block->size;
+  if (buddy_offset + block->size > total_pool_size) {
+    return nullptr;
+  }
+  char *buddy_address = memory_pool + buddy_offset;
+  for (BuddyBlock *current = free_lists[block->order]; current;
+       current = current->next) {
+    if (current->is_free && current->base_address == buddy_address) {
+      return current;
     }
   }
-
-  return false;
+  return nullptr;
 }
 
-void Buffer_BuddySystem::merge_buddies(BuddyBlock *block) {
-  if (!block || !block->buddy || !block->buddy->is_free) {
-    return;
+void Buffer_BuddySystem::remove_from_free_list(BuddyBlock *block) {
+  BuddyBlock *current = free_lists[block->order];
+  BuddyBlock *prev = nullptr;
+  while (current) {
+    if (current == block) {
+      if (prev) {
+        prev->next = current->next;
+      } else {
+        free_lists[block->order] = current->next;
+      }
+      current->next = nullptr;
+      return;
+    }
+    prev = current;
+    current = current->next;
   }
+}
 
-  BuddyBlock *buddy = block->buddy;
-
-  // 检查是否可以合并（同一级别且都空闲）
-  if (block->order == buddy->order && block->is_free && buddy->is_free) {
-    size_t merged_order = block->order + 1;
-
-    if (merged_order > max_order) {
-      return; // 不能超过最大级别
+void Buffer_BuddySystem::merge_buddies(BuddyBlock *block) {
+  // 逐级向上合并，直到伙伴不空闲或到达最大级别
+  while (block && block->order < max_order) {
+    BuddyBlock *buddy = find_buddy(block);
+    if (!buddy) {
+      return;
     }
 
     // 确定左右块
@@ -205,51 +228,78 @@ void Buffer_BuddySystem::merge_buddies(BuddyBlock *block) {
         (block->base_address < buddy->base_address) ? buddy : block;
 
     // 从当前级别链表中移除两个块
-    BuddyBlock *current = free_lists[block->order];
-    BuddyBlock *prev = nullptr;
-    while (current) {
-      if (current == left_block || current == right_block) {
-        if (prev) {
-          prev->next = current->next;
-        } else {
-          free_lists[block->order] = current->next;
-        }
-      } else {
-        prev = current;
-      }
-      current = current->next;
-    }
+    remove_from_free_list(left_block);
+    remove_from_free_list(right_block);
 
-    // 创建合并后的大块
+    // 创建合并后的大块，加入更高级别的空闲链表
+    size_t merged_order = block->order + 1;
     BuddyBlock *merged_block = new BuddyBlock(
         left_block->base_address, left_block->size * 2, merged_order);
-
-    // 加入更高级别的空闲链表
+    merged_block->purged = left_block->purged && right_block->purged;
     merged_block->next = free_lists[merged_order];
     free_lists[merged_order] = merged_block;
 
     // 删除原来的小块
     delete left_block;
     delete right_block;
-
-    // 递归尝试继续合并
-    merge_buddies(merged_block);
+    block = merged_block;
   }
 }
 
 void Buffer_BuddySystem::defragment() {
   std::lock_guard<std::mutex> lock(pool_mutex);
+  defragment_locked();
+}
 
-  // 尝试合并所有可能的伙伴块
+void Buffer_BuddySystem::defragment_locked() {
+  // 尝试合并所有可能的伙伴块，合并后链表已变化，从头重新扫描该级别
   for (size_t order = 0; order < max_order; ++order) {
     BuddyBlock *current = free_lists[order];
     while (current) {
-      if (current->is_free) {
+      if (current->is_free && find_buddy(current)) {
         merge_buddies(current);
+        current = free_lists[order];
+      } else {
+        current = current->next;
+      }
+    }
+  }
+}
+
+size_t Buffer_BuddySystem::release_free_memory() {
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  defragment_locked();
+
+  size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t released = 0;
+  for (size_t order = 0; order <= max_order; ++order) {
+    for (BuddyBlock *current = free_lists[order]; current;
+         current = current->next) {
+      if (!current->is_free || current->purged || current->size < page_size) {
+        continue;
+      }
+      if (madvise(current->base_address, current->size, MADV_DONTNEED) == 0) {
+        current->purged = true;
+        released += current->size;
+      }
+    }
+  }
+  return released;
+}
+
+size_t Buffer_BuddySystem::get_resident_bytes() {
+  std::lock_guard<std::mutex> lock(pool_mutex);
+
+  size_t purged = 0;
+  for (size_t order = 0; order <= max_order; ++order) {
+    for (BuddyBlock *current = free_lists[order]; current;
+         current = current->next) {
+      if (current->purged) {
+        purged += current->size;
       }
-      current = current->next;
     }
   }
+  return total_pool_size - purged;
 }
 
 size_t Buffer_BuddySystem::get_fragmentation() {
@@ -2,6 +2,7 @@
 
 // C++标准库头文件
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 // 伙伴系统模块专用配置
@@ -17,16 +18,18 @@ private:
     size_t size;
     size_t order; //块的级别（0最小，max_order最大）
     bool is_free;
+    bool purged; // 物理页已通过madvise归还系统
     BuddyBlock *buddy;
     BuddyBlock *next;
 
     BuddyBlock(char *addr, size_t block_size, size_t block_order)
         : base_address(addr), size(block_size), order(block_order),
-          is_free(true), buddy(nullptr), next(nullptr) {}
+          is_free(true), purged(false), buddy(nullptr), next(nullptr) {}
   };
 
   //空闲链表数组，每一个级别一个链表
   std::vector<BuddyBlock *> free_lists;
+  std::unordered_map<char *, BuddyBlock *> allocated_blocks; //已分配块索引
   char *memory_pool; //开始地址
   size_t total_pool_size;
   size_t min_block_size;
@@ -36,8 +39,10 @@ private:
   //私有辅助方法
   size_t calculate_order(size_t size) const;
   BuddyBlock *find_buddy(BuddyBlock *block);
+  void remove_from_free_list(BuddyBlock *block);
   void merge_buddies(BuddyBlock *block);
   void split_block(size_t required_order);
+  void defragment_locked();
 
 public:
   Buffer_BuddySystem(size_t pool_size,
@@ -47,6 +52,10 @@ public:
   char *allocate_buffer(size_t size);
   bool deallocate_buffer(char *ptr);
   void defragment();
+  // 合并伙伴块后，把完全空闲块的物理页归还系统，返回归还字节数
+  size_t release_free_memory();
+  // 估算常驻内存（已归还的空闲块不计）
+  size_t get_resident_bytes();
   size_t get_fragmentation();
   size_t get_available_memory();
   void print_memory_status();
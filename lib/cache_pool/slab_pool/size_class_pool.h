@@ -0,0 +1,285 @@
+#pragma once
+
+// C++标准库头文件
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+
+// 尺寸分级对象池专用配置（kmem_cache风格：每个尺寸级别一组slab）
+#define SIZE_CLASS_MIN_SHIFT 4                              // 最小级别 16B
+#define SIZE_CLASS_MAX_SHIFT 11                             // 最大级别 2KB
+#define SIZE_CLASS_MIN_SIZE (1UL << SIZE_CLASS_MIN_SHIFT)
+#define SIZE_CLASS_MAX_SIZE (1UL << SIZE_CLASS_MAX_SHIFT)
+#define SIZE_CLASS_COUNT (SIZE_CLASS_MAX_SHIFT - SIZE_CLASS_MIN_SHIFT + 1)
+#define SIZE_CLASS_SLAB_BYTES (64 * 1024) // 每个slab大小，同时也是对齐粒度
+
+// 小对象分级内存池：16B~2KB按2次幂分级，每级独立的slab链表（空 满 部分）
+// slab按SIZE_CLASS_SLAB_BYTES对齐，释放时通过地址掩码直接找到所属slab，O(1)
+class SizeClassPool {
+private:
+  // 空闲对象：空闲时对象内存本身存放下一个空闲对象指针
+  struct FreeObject {
+    FreeObject *next;
+  };
+
+  // slab头部，位于slab内存起始处
+  struct SlabHeader {
+    SlabHeader *prev;
+    SlabHeader *next;
+    FreeObject *free_list; // 空闲对象链表
+    size_t free_count;     // 空闲对象数
+    size_t capacity;       // 对象总数
+    size_t class_index;    // 所属尺寸级别
+
+    bool is_completely_free() const { return free_count == capacity; }
+    bool is_completely_used() const { return free_count == 0; }
+  };
+
+  // 每个尺寸级别的缓存（相当于一个kmem_cache）
+  struct SizeClassCache {
+    SlabHeader *partial_slabs = nullptr;  // 部分使用的slab链表
+    SlabHeader *complete_slabs = nullptr; // 完全使用的slab链表
+    SlabHeader *empty_slabs = nullptr;    // 空slab链表
+    size_t object_size = 0;
+    size_t slab_count = 0;
+    size_t active_objects = 0;
+    std::mutex cache_mutex;
+  };
+
+  std::array<SizeClassCache, SIZE_CLASS_COUNT> _caches;
+
+  // 对象区起始偏移（头部按16字节对齐）
+  static constexpr size_t header_bytes() {
+    return (sizeof(SlabHeader) + SIZE_CLASS_MIN_SIZE - 1) &
+           ~(SIZE_CLASS_MIN_SIZE - 1);
+  }
+
+  static void list_push(SlabHeader *&head, SlabHeader *s) {
+    s->prev = nullptr;
+    s->next = head;
+    if (head) {
+      head->prev = s;
+    }
+    head = s;
+  }
+
+  static void list_remove(SlabHeader *&head, SlabHeader *s) {
+    if (s->prev) {
+      s->prev->next = s->next;
+    } else {
+      head = s->next;
+    }
+    if (s->next) {
+      s->next->prev = s->prev;
+    }
+    s->prev = s->next = nullptr;
+  }
+
+  // 新建一个slab并切分成空闲对象链表
+  SlabHeader *create_slab(size_t class_index) {
+    void *memory = std::aligned_alloc(SIZE_CLASS_SLAB_BYTES,
+                                      SIZE_CLASS_SLAB_BYTES);
+    if (!memory) {
+      return nullptr;
+    }
+    SlabHeader *s = static_cast<SlabHeader *>(memory);
+    size_t object_size = _caches[class_index].object_size;
+    s->prev = s->next = nullptr;
+    s->class_index = class_index;
+    s->capacity = (SIZE_CLASS_SLAB_BYTES - header_bytes()) / object_size;
+    s->free_count = s->capacity;
+
+    // 倒序串起来，使分配顺序与地址顺序一致
+    char *base = static_cast<char *>(memory) + header_bytes();
+    FreeObject *head = nullptr;
+    for (size_t i = s->capacity; i > 0; --i) {
+      FreeObject *obj = reinterpret_cast<FreeObject *>(base +
+                                                       (i - 1) * object_size);
+      obj->next = head;
+      head = obj;
+    }
+    s->free_list = head;
+    return s;
+  }
+
+  static SlabHeader *slab_of(void *ptr) {
+    return reinterpret_cast<SlabHeader *>(reinterpret_cast<uintptr_t>(ptr) &
+                                          ~uintptr_t(SIZE_CLASS_SLAB_BYTES - 1));
+  }
+
+public:
+  SizeClassPool() {
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+      _caches[i].object_size = SIZE_CLASS_MIN_SIZE << i;
+    }
+  }
+
+  ~SizeClassPool() {
+    for (auto &cache : _caches) {
+      for (SlabHeader *head :
+           {cache.partial_slabs, cache.complete_slabs, cache.empty_slabs}) {
+        while (head) {
+          SlabHeader *next = head->next;
+          std::free(head);
+          head = next;
+        }
+      }
+    }
+  }
+
+  SizeClassPool(const SizeClassPool &) = delete;
+  SizeClassPool &operator=(const SizeClassPool &) = delete;
+
+  // 尺寸 -> 级别索引（向上取2次幂）
+  static size_t class_index_of(size_t size) {
+    if (size <= SIZE_CLASS_MIN_SIZE) {
+      return 0;
+    }
+    return (64 - __builtin_clzll(size - 1)) - SIZE_CLASS_MIN_SHIFT;
+  }
+
+  // 级别实际对象大小
+  static size_t class_size_of(size_t size) {
+    return SIZE_CLASS_MIN_SIZE << class_index_of(size);
+  }
+
+  // 分配一个size字节的对象，超过SIZE_CLASS_MAX_SIZE返回nullptr
+  void *allocate(size_t size) {
+    if (size == 0 || size > SIZE_CLASS_MAX_SIZE) {
+      return nullptr;
+    }
+    size_t index = class_index_of(size);
+    SizeClassCache &cache = _caches[index];
+    std::lock_guard<std::mutex> lock(cache.cache_mutex);
+
+    // 优先从部分使用的slab分配，其次空slab，最后新建slab
+    SlabHeader *s = cache.partial_slabs;
+    if (!s) {
+      s = cache.empty_slabs;
+      if (s) {
+        list_remove(cache.empty_slabs, s);
+      } else {
+        s = create_slab(index);
+        if (!s) {
+          return nullptr;
+        }
+        cache.slab_count++;
+      }
+      list_push(cache.partial_slabs, s);
+    }
+
+    FreeObject *obj = s->free_list;
+    s->free_list = obj->next;
+    s->free_count--;
+    cache.active_objects++;
+
+    // slab变为完全使用，移动到full链表
+    if (s->is_completely_used()) {
+      list_remove(cache.partial_slabs, s);
+      list_push(cache.complete_slabs, s);
+    }
+    return obj;
+  }
+
+  // 释放对象，所属slab与级别都由地址推出
+  void deallocate(void *ptr) {
+    if (!ptr) {
+      return;
+    }
+    SlabHeader *s = slab_of(ptr);
+    SizeClassCache &cache = _caches[s->class_index];
+    std::lock_guard<std::mutex> lock(cache.cache_mutex);
+
+    bool was_full = s->is_completely_used();
+    FreeObject *obj = static_cast<FreeObject *>(ptr);
+    obj->next = s->free_list;
+    s->free_list = obj;
+    s->free_count++;
+    cache.active_objects--;
+
+    // 根据slab状态重新分类
+    if (was_full) {
+      list_remove(cache.complete_slabs, s);
+      list_push(cache.partial_slabs, s);
+    }
+    if (s->is_completely_free()) {
+      list_remove(cache.partial_slabs, s);
+      list_push(cache.empty_slabs, s);
+    }
+  }
+
+  // 回收空slab：每个级别保留reserve_per_class个空slab，总共最多释放max_bytes
+  // 返回实际归还给系统的字节数
+  size_t trim(size_t reserve_per_class, size_t max_bytes) {
+    size_t released = 0;
+    for (auto &cache : _caches) {
+      std::lock_guard<std::mutex> lock(cache.cache_mutex);
+      size_t empty_count = 0;
+      for (SlabHeader *s = cache.empty_slabs; s; s = s->next) {
+        empty_count++;
+      }
+      while (empty_count > reserve_per_class &&
+             released + SIZE_CLASS_SLAB_BYTES <= max_bytes) {
+        SlabHeader *victim = cache.empty_slabs;
+        list_remove(cache.empty_slabs, victim);
+        std::free(victim);
+        cache.slab_count--;
+        empty_count--;
+        released += SIZE_CLASS_SLAB_BYTES;
+      }
+    }
+    return released;
+  }
+
+  // 统计信息
+  struct ClassStats {
+    size_t object_size;
+    size_t slab_count;
+    size_t active_objects;
+  };
+
+  ClassStats get_class_stats(size_t class_index) {
+    SizeClassCache &cache = _caches[class_index];
+    std::lock_guard<std::mutex> lock(cache.cache_mutex);
+    return {cache.object_size, cache.slab_count, cache.active_objects};
+  }
+
+  // 向系统申请的总字节数
+  size_t get_reserved_bytes() {
+    size_t total = 0;
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+      total += get_class_stats(i).slab_count * SIZE_CLASS_SLAB_BYTES;
+    }
+    return total;
+  }
+
+  // 已分配出去的对象字节数（按级别大小计）
+  size_t get_active_bytes() {
+    size_t total = 0;
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+      ClassStats stats = get_class_stats(i);
+      total += stats.active_objects * stats.object_size;
+    }
+    return total;
+  }
+
+  void print_stats() {
+    std::cout << "=== Size Class Pool Statistics ===" << std::endl;
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+      ClassStats stats = get_class_stats(i);
+      if (stats.slab_count == 0) {
+        continue;
+      }
+      std::cout << "级别 " << stats.object_size << "B: Slab数="
+                << stats.slab_count << ", 活动对象=" << stats.active_objects
+                << std::endl;
+    }
+    std::cout << "保留内存: " << get_reserved_bytes() << " 字节" << std::endl;
+    std::cout << "使用内存: " << get_active_bytes() << " 字节" << std::endl;
+    std::cout << "==================================" << std::endl;
+  }
+};
@@ -32,11 +32,9 @@ private:
 
     ~slab() {
       if (objects) {
-        // 手动调用析构函数
+        // 手动调用析构函数（构造时64个对象全部构造过，空闲的也要析构）
         for (size_t i = 0; i < 64; ++i) {
-          if (!free_set.test(i)) {
-            objects[i].~T();
-          }
+          objects[i].~T();
         }
         // 释放内存
         ::operator delete(objects);
@@ -106,13 +104,18 @@ private:
   void preallocate_slabs(size_t count) {
     std::lock_guard<std::mutex> lock(_cache.cache_mutex);
     for (size_t i = 0; i < count; ++i) {
-      slab *new_slab = new slab(64); // 每个slab 64个对象
-      new_slab->next = _cache.empty_slabs;
-      _cache.empty_slabs = new_slab;
-      _total_objects += 64;
+      add_empty_slab();
     }
   }
 
+  // 新建一个空slab挂到空链表（调用者持有cache_mutex）
+  void add_empty_slab() {
+    slab *new_slab = new slab(64); // 每个slab 64个对象
+    new_slab->next = _cache.empty_slabs;
+    _cache.empty_slabs = new_slab;
+    _total_objects += 64;
+  }
+
   // 统计slab数量
   size_t count_slab(slab *head) const {
     size_t count = 0;
@@ -166,52 +169,34 @@ private:
         // 添加到部分使用的链表中
         slab_ptr->next = _cache.partial_slabs;
         _cache.partial_slabs = slab_ptr;
-        _total_objects += 64;
         return &slab_ptr->objects[index];
       }
     }
 
     // 如果还没有可用的对象，创建新的slab
-    if (_total_objects.load() < _max_objects_) {
-      if (new_slab_count()) {
-        slab_ptr = _cache.empty_slabs;
-        if (slab_ptr) {
-          _cache.empty_slabs = slab_ptr->next;
-          int index = slab_ptr->find_first_free();
-          if (index != -1) {
-            slab_ptr->free_set.reset(index);
-            slab_ptr->free_cout--;
-
-            // 添加到部分使用的链表中
-            slab_ptr->next = _cache.partial_slabs;
-            _cache.partial_slabs = slab_ptr;
-            _total_objects += 64;
-            return &slab_ptr->objects[index];
-          }
-        }
+    if (new_slab_count()) {
+      slab_ptr = _cache.empty_slabs;
+      _cache.empty_slabs = slab_ptr->next;
+      int index = slab_ptr->find_first_free();
+      if (index != -1) {
+        slab_ptr->free_set.reset(index);
+        slab_ptr->free_cout--;
+
+        // 添加到部分使用的链表中
+        slab_ptr->next = _cache.partial_slabs;
+        _cache.partial_slabs = slab_ptr;
+        return &slab_ptr->objects[index];
       }
     }
     return nullptr;
   }
 
+  // 按需增长一个slab（调用者持有cache_mutex），达到上限返回false
   bool new_slab_count() {
-    size_t count = _total_objects.load();
-    for (; count < _max_objects_; count += 64) {
-      break;
-    }
-
-    size_t slab_count = (count - 64 - _total_objects.load()) / 68;
-    if (slab_count == 0) {
+    if (_total_objects.load() + 64 > _max_objects_) {
       return false;
-    } else if (slab_count == 1) {
-      preallocate_slabs(1);
-    } else {
-      slab_count = slab_count / 2;
-    }
-
-    for (size_t i = 0; i < slab_count; i++) {
-      preallocate_slabs(1);
     }
+    add_empty_slab();
     return true;
   }
 
@@ -379,6 +364,31 @@ public:
     _active_objects--;
   }
 
+  // 回收空slab：保留reserve_slabs个空slab备用，其余最多释放max_slabs个
+  // 返回实际释放的slab数
+  size_t trim(size_t reserve_slabs, size_t max_slabs) {
+    std::lock_guard<std::mutex> lock(_pool_mutex);
+    std::lock_guard<std::mutex> cache_lock(_cache.cache_mutex);
+
+    size_t empty_count = count_slabs(_cache.empty_slabs);
+    size_t released = 0;
+    while (empty_count > reserve_slabs && released < max_slabs) {
+      slab *victim = _cache.empty_slabs;
+      _cache.empty_slabs = victim->next;
+      delete victim;
+      _total_objects -= 64;
+      empty_count--;
+      released++;
+    }
+    return released;
+  }
+
+  // 当前持有的slab总数
+  size_t get_slab_count() {
+    std::lock_guard<std::mutex> lock(_pool_mutex);
+    return _total_objects.load() / 64;
+  }
+
   // 直接打印统计信息 - 更实用的方式
   void print_stats() {
     std::lock_guard<std::mutex> lock(_pool_mutex);
@@ -1,9 +1,15 @@
 #include "http_complete.h"
+#include <charconv>
 #include <chrono>
+#include <cstdio>
+#include <fcntl.h>
 #include <filesystem>
+#include <new>
+#include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 
-// 判断报文是否完整
+// 判断报文是否完整：增量解析，只扫描上次之后新到达的字节
 ParseResult HttpTask::is_complete_message(UringConnectionInfo *info) {
   char *read_head = info->read_buffer.get_read_head();
   size_t read_size = info->read_buffer.get_readable_size();
@@ -11,287 +17,794 @@ ParseResult HttpTask::is_complete_message(UringConnectionInfo *info) {
     return ParseResult::NEEED_MORE_DATA;
   }
 
-  std::string_view request(read_head, read_size);
+  HttpParser &parser = info->parser;
+  ParseResult result = parser.execute(read_head, read_size, info->body_sink);
+  if (result == ParseResult::NEEED_MORE_DATA && parser.is_chunked() &&
+      parser.headers_complete() && info->body_sink == nullptr) {
+    // 头部刚解析完，先为chunked请求体准备接收端再继续解码
+    info->body_sink = open_body_sink(info);
+    result = parser.execute(read_head, read_size, info->body_sink);
+  }
 
-  // 查找请求头结束标记
-  size_t headers_end = request.find("\r\n\r\n");
-  if (headers_end == std::string_view::npos) {
-    return ParseResult::NEEED_MORE_DATA;
+  if (parser.is_chunked()) {
+    // 已交付的分块不再保留，读缓冲区只剩头部和还没解码的字节
+    info->read_buffer.erase(parser.body_offset(),
+                            parser.release_chunked_input());
+    info->bytes_NO_read = 0;
+  } else if (result == ParseResult::NEEED_MORE_DATA &&
+             parser.headers_complete()) {
+    // 头部已完整，还差请求体
+    info->bytes_NO_read = parser.message_length() - read_size;
+  } else {
+    info->bytes_NO_read = 0;
   }
+  return result;
+}
 
-  // 解析Content-Length
-  size_t content_length_pos = request.find("Content-Length:");
-  if (content_length_pos != std::string_view::npos &&
-      content_length_pos < headers_end) {
-    size_t content_length_end = request.find("\r\n", content_length_pos);
-    if (content_length_end != std::string_view::npos) {
-      try {
-        std::string content_len_str = std::string(
-            request.substr(content_length_pos + 15,
-                           content_length_end - (content_length_pos + 15)));
-        // 去除空格
-        content_len_str.erase(0, content_len_str.find_first_not_of(" \t"));
-        content_len_str.erase(content_len_str.find_last_not_of(" \t") + 1);
-
-        size_t content_len = std::stoul(content_len_str);
-        size_t total_expected = headers_end + 4 + content_len;
-
-        if (read_size >= total_expected) {
-          info->bytes_NO_read = total_expected - read_size;
-          return ParseResult::COMPLETE;
-        } else {
-          info->bytes_NO_read = total_expected - read_size;
-          return ParseResult::NEEED_MORE_DATA;
-        }
-      } catch (const std::exception &e) {
-        return ParseResult::INVALID_FORMAT;
-      }
+namespace {
+
+// 在请求分配区中构造接收端，随连接的close_body_sink析构
+template <typename Sink>
+HttpBodySink *make_body_sink(std::pmr::memory_resource *mr) {
+  void *memory = mr->allocate(sizeof(Sink), alignof(Sink));
+  return new (memory) Sink();
+}
+
+} // namespace
+
+// 创建chunked请求体接收端
+HttpBodySink *HttpTask::open_body_sink(UringConnectionInfo *info) {
+  const Route *route = find_route(info);
+  BodySinkFactory factory = route && route->body_sink
+                                ? route->body_sink
+                                : &make_body_sink<HttpCountingBodySink>;
+  return factory(info->arena.resource());
+}
+
+namespace {
+
+constexpr std::string_view kNotFoundBody = "Not Found";
+constexpr std::string_view kNotFoundHeaders =
+    "Content-Type: text/plain; charset=utf-8\r\nContent-Length: 9\r\n";
+static_assert(kNotFoundBody.size() == 9,
+              "404头部的Content-Length须与响应体一致");
+
+// Connection头部是逗号分隔的选项列表，token须为小写
+bool has_connection_token(std::string_view value, std::string_view token) {
+  while (!value.empty()) {
+    size_t comma = value.find(',');
+    std::string_view item = value.substr(0, comma);
+    while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+      item.remove_prefix(1);
+    }
+    while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+      item.remove_suffix(1);
+    }
+    if (http_iequals(item, token)) {
+      return true;
     }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    value.remove_prefix(comma + 1);
   }
+  return false;
+}
 
-  // 检查Transfer-Encoding: chunked
-  size_t chunked_pos = request.find("Transfer-Encoding: chunked");
-  if (chunked_pos != std::string_view::npos && chunked_pos < headers_end) {
-    return ParseResult::CHUNKED_UNSUPPORTED; // 暂不支持chunked编码
+// If-None-Match是逗号分隔的ETag列表或*，按弱比较（忽略W/前缀）
+bool etag_list_matches(std::string_view list, std::string_view etag) {
+  while (!list.empty()) {
+    size_t comma = list.find(',');
+    std::string_view item = list.substr(0, comma);
+    while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+      item.remove_prefix(1);
+    }
+    while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+      item.remove_suffix(1);
+    }
+    if (item.substr(0, 2) == "W/") {
+      item.remove_prefix(2);
+    }
+    if (item == "*" || item == etag) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
   }
+  return false;
+}
 
-  // 没有Content-Length，只有请求头的情况（如GET请求）
-  return ParseResult::COMPLETE;
+// If-Range是强ETag或日期，与当前版本完全一致时才按范围响应
+bool if_range_matches(std::string_view value, std::string_view etag,
+                      time_t last_modified) {
+  if (!value.empty() && value.front() == '"') {
+    return value == etag;
+  }
+  time_t date;
+  return http_parse_date(value, date) && date == last_modified;
 }
 
-// 解析请求行
-bool HttpTask::parse_request_line(std::string_view data) {
-  size_t line_end = data.find("\r\n");
-  if (line_end == std::string_view::npos) {
-    return false;
+// Accept-Encoding中coding的q值（千分比），没有列出时取fallback
+int accept_encoding_quality(std::string_view accept, std::string_view coding,
+                            int fallback) {
+  while (!accept.empty()) {
+    size_t comma = accept.find(',');
+    std::string_view item = accept.substr(0, comma);
+    accept = comma == std::string_view::npos ? std::string_view()
+                                             : accept.substr(comma + 1);
+    size_t semicolon = item.find(';');
+    std::string_view name = item.substr(0, semicolon);
+    while (!name.empty() && (name.front() == ' ' || name.front() == '\t')) {
+      name.remove_prefix(1);
+    }
+    while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) {
+      name.remove_suffix(1);
+    }
+    if (!http_iequals(name, coding)) {
+      continue;
+    }
+    if (semicolon == std::string_view::npos) {
+      return 1000;
+    }
+    // q=0、q=0.5、q=1.000
+    std::string_view params = item.substr(semicolon + 1);
+    size_t q = params.find("q=");
+    if (q == std::string_view::npos) {
+      return 1000;
+    }
+    std::string_view value = params.substr(q + 2);
+    if (value.empty() || value[0] == '1') {
+      return 1000;
+    }
+    int quality = 0;
+    int scale = 100;
+    for (size_t i = 2; i < value.size() && i < 5 && value[i] >= '0' &&
+                       value[i] <= '9';
+         ++i) {
+      quality += (value[i] - '0') * scale;
+      scale /= 10;
+    }
+    return quality;
   }
+  return fallback;
+}
 
-  std::string_view request_line = data.substr(0, line_end);
+// 文件响应体：每次只读写缓冲区放得下的部分。read会阻塞，只用于不由
+// 事件循环驱动的连接，事件循环上的文件响应走环上的文件流
+class FileBodyProducer : public HttpBodyProducer {
+private:
+  int fd_;
+
+public:
+  explicit FileBodyProducer(int fd) : fd_(fd) {}
+  ~FileBodyProducer() override { close(fd_); }
+
+  size_t produce(char *out, size_t capacity, bool &finished) override {
+    ssize_t n = read(fd_, out, capacity);
+    if (n <= 0) {
+      finished = true;
+      return 0;
+    }
+    return static_cast<size_t>(n);
+  }
+};
 
-  // 解析方法
-  size_t method_end = request_line.find(' ');
-  if (method_end == std::string_view::npos) {
+} // namespace
+
+bool HttpTask::request_keeps_alive(const HttpRequest &request) {
+  std::string_view connection = request.headers.get(HttpHeaderId::CONNECTION);
+  if (has_connection_token(connection, "close")) {
     return false;
   }
-  request_.method = request_line.substr(0, method_end);
+  if (request.version == "HTTP/1.0") {
+    return has_connection_token(connection, "keep-alive");
+  }
+  return true;
+}
 
-  // 解析URL
-  size_t url_start = method_end + 1;
-  size_t url_end = request_line.find(' ', url_start);
-  if (url_end == std::string_view::npos) {
-    return false;
+// 根据解析器区间填充请求
+void HttpTask::populate_request(const HttpParser &parser, const char *base,
+                                size_t available, std::string_view overflow) {
+  request_.method = parser.method(base);
+  request_.url = parser.url(base);
+  request_.version = parser.version(base);
+  for (size_t i = 0; i < parser.header_count(); ++i) {
+    const HttpHeaderSpan &header = parser.header(i);
+    request_.headers.add(header.id, header.name.view(base),
+                         header.value.view(base));
+  }
+  request_.content_length = parser.body_length();
+  request_.is_chunked = parser.is_chunked();
+  if (parser.is_chunked()) {
+    // 请求体已经交付给接收端
+    return;
   }
-  request_.url = request_line.substr(url_start, url_end - url_start);
+  // 头部一定在读缓冲区内，请求体可能跨到额外缓冲区
+  size_t body_offset = parser.body_offset();
+  size_t in_buffer =
+      std::min(parser.content_length(), available - body_offset);
+  request_.body = SegmentedView(
+      std::string_view(base + body_offset, in_buffer),
+      overflow.substr(0, parser.content_length() - in_buffer));
+}
 
-  // 解析HTTP版本
-  request_.version = request_line.substr(url_end + 1);
+// 发送简单响应
+bool HttpTask::send_simple_response(UringConnectionInfo *info,
+                                    HttpResponse &response) {
+  response.keep_alive = info->keep_alive;
+  // 直接在写缓冲区尾部就地序列化，空间不足时不提交任何字节
+  HttpResponseWriter writer(info->write_buffer.get_write_tail(),
+                            info->write_buffer.get_writable_size());
+  writer.write_headers(response);
+  writer.write_body(response.body);
+  if (!writer.ok()) {
+    std::cerr << "写缓冲区空间不足，可用"
+              << info->write_buffer.get_writable_size() << "字节" << std::endl;
+    return false;
+  }
+  info->write_buffer.write_data(writer.size());
 
-  parse_state_.request_line_parsed = true;
+  std::cout << "HTTP响应已写入缓冲区，总大小: " << writer.size()
+            << "字节（体:" << response.body.size() << "字节）" << std::endl;
+  std::cout << "响应状态行: " << http_status_line(response.status);
   return true;
 }
 
-// 解析请求头
-bool HttpTask::parse_request_headers(std::string_view data) {
-  size_t headers_start = data.find("\r\n") + 2;
-  size_t headers_end = data.find("\r\n\r\n");
+bool HttpTask::is_not_modified(std::string_view etag,
+                               time_t last_modified) const {
+  if (request_.headers.contains(HttpHeaderId::IF_NONE_MATCH)) {
+    return etag_list_matches(request_.headers.get(HttpHeaderId::IF_NONE_MATCH),
+                             etag);
+  }
+  time_t since;
+  return request_.headers.contains(HttpHeaderId::IF_MODIFIED_SINCE) &&
+         http_parse_date(request_.headers.get(HttpHeaderId::IF_MODIFIED_SINCE),
+                         since) &&
+         last_modified <= since;
+}
+
+// 发送304
+bool HttpTask::send_not_modified(UringConnectionInfo *info,
+                                 std::string_view validators) {
+  HttpResponse response;
+  response.status = HttpStatus::NOT_MODIFIED;
+  response.preformatted = validators;
+  return send_simple_response(info, response);
+}
+
+// 静态文件的404：实体头部预先格式化好，只补状态行、Date和Connection
+bool HttpTask::send_not_found(UringConnectionInfo *info) {
+  HttpResponse response;
+  response.status = HttpStatus::NOT_FOUND;
+  response.preformatted = kNotFoundHeaders;
+  response.set_body(kNotFoundBody);
+  return send_simple_response(info, response);
+}
 
-  if (headers_end == std::string_view::npos) {
+// 发送Range响应
+bool HttpTask::send_range_response(UringConnectionInfo *info,
+                                   HttpRangeSource &source) {
+  if (!request_.headers.contains(HttpHeaderId::RANGE)) {
+    return false;
+  }
+  // If-Range不匹配说明客户端手里是旧版本，返回完整内容
+  if (request_.headers.contains(HttpHeaderId::IF_RANGE) &&
+      !if_range_matches(request_.headers.get(HttpHeaderId::IF_RANGE),
+                        source.etag, source.last_modified)) {
+    return false;
+  }
+  HttpByteRange ranges[HTTP_MAX_RANGES];
+  size_t count;
+  HttpRangeResult result = http_parse_ranges(
+      request_.headers.get(HttpHeaderId::RANGE), source.size, ranges, count);
+  if (result == HttpRangeResult::NONE) {
     return false;
   }
 
-  std::string_view headers_data =
-      data.substr(headers_start, headers_end - headers_start);
+  HttpResponse response;
+  char content_range[kContentRangeMaxSize];
+  if (result == HttpRangeResult::UNSATISFIABLE) {
+    if (source.fd >= 0 && !source.borrowed) {
+      close(source.fd);
+      source.fd = -1;
+    }
+    size_t size = std::snprintf(content_range, sizeof(content_range),
+                                "bytes */%zu", source.size);
+    response.status = HttpStatus::RANGE_NOT_SATISFIABLE;
+    response.content_type = HttpMime::PLAIN;
+    response.add_header("Content-Range",
+                        std::string_view(content_range, size));
+    response.set_body("Range Not Satisfiable");
+    send_simple_response(info, response);
+    return true;
+  }
 
-  size_t line_start = 0;
-  while (line_start < headers_data.length()) {
-    size_t line_end = headers_data.find("\r\n", line_start);
-    if (line_end == std::string_view::npos) {
-      line_end = headers_data.length();
+  char date[kHttpDateSize];
+  http_format_date(date, source.last_modified);
+  response.status = HttpStatus::PARTIAL_CONTENT;
+  response.add_header("ETag", source.etag);
+  response.add_header("Last-Modified", std::string_view(date, sizeof(date)));
+  if (count == 1) {
+    response.content_type = source.mime;
+    response.add_header(
+        "Content-Range",
+        std::string_view(content_range,
+                         http_format_content_range(content_range, ranges[0],
+                                                   source.size)));
+  } else {
+    response.content_type = HttpMime::NONE;
+    response.add_header("Content-Type", kByterangesContentType);
+  }
+  response.set_content_length(
+      HttpRangeBodyProducer::body_length(source, ranges, count));
+
+  if (source.fd >= 0 && info->ring_file_io) {
+    // 由事件循环驱动：按偏移在环上读各段，多段时段之间写入分隔头部
+    if (send_simple_response(info, response)) {
+      if (count == 1) {
+        info->file_stream.start(source.fd, ranges[0].first,
+                                ranges[0].length());
+      } else {
+        info->file_stream.start_parts(source.fd, source.mime, source.size,
+                                      ranges, count);
+      }
+      if (source.borrowed) {
+        info->file_stream.borrow_from(info->file_op);
+      }
+    } else if (!source.borrowed) {
+      close(source.fd);
     }
+    source.fd = -1;
+    return true;
+  }
+  if (count == 1 && source.fd < 0) {
+    // 单段且内容在缓存中：响应体直接从缓存写出
+    if (send_simple_response(info, response)) {
+      info->set_output_segment(
+          std::move(source.owner),
+          source.data.substr(ranges[0].first, ranges[0].length()));
+    }
+    return true;
+  }
+  // 缓存内容的多段响应，或不由事件循环驱动（数据源在工作线程pread）
+  void *memory = mr_->allocate(sizeof(HttpRangeBodyProducer),
+                               alignof(HttpRangeBodyProducer));
+  auto *producer =
+      new (memory) HttpRangeBodyProducer(std::move(source), ranges, count);
+  source.fd = -1;
+  send_stream_response(info, response, producer);
+  return true;
+}
 
-    std::string_view header_line =
-        headers_data.substr(line_start, line_end - line_start);
-    size_t colon_pos = header_line.find(':');
-    if (colon_pos != std::string_view::npos) {
-      std::string_view key = header_line.substr(0, colon_pos);
-      std::string_view value = header_line.substr(colon_pos + 1);
+// 发送流式响应
+bool HttpTask::send_stream_response(UringConnectionInfo *info,
+                                    HttpResponse &response,
+                                    HttpBodyProducer *producer) {
+  if (response.framing == HttpBodyFraming::CHUNKED &&
+      request_.version == "HTTP/1.0") {
+    // HTTP/1.0客户端不认识分块编码，改为以关闭连接表示结束
+    response.framing = HttpBodyFraming::UNTIL_CLOSE;
+  }
+  if (response.framing == HttpBodyFraming::UNTIL_CLOSE) {
+    info->keep_alive = false;
+  }
+  response.body = std::string_view();
+  if (!send_simple_response(info, response)) {
+    producer->~HttpBodyProducer();
+    return false;
+  }
+  // 先填满写缓冲区剩余空间，之后每次写完成再继续拉取
+  info->response_stream.start(producer, response.framing,
+                              response.content_length);
+  info->pump_response_stream();
+  return true;
+}
 
-      // 去除value前后的空格
-      size_t value_start = value.find_first_not_of(" \t");
-      size_t value_end = value.find_last_not_of(" \t");
-      if (value_start != std::string_view::npos &&
-          value_end != std::string_view::npos) {
-        value = value.substr(value_start, value_end - value_start + 1);
-      }
+// 发送文件响应
+void HttpTask::send_file_response(UringConnectionInfo *info,
+                                  const std::pmr::string &file_path) {
+  // 由事件循环驱动时打开、stat和读文件都是环上的操作，工作线程不阻塞在磁盘上；
+  // 否则（基准程序等）直接open/fstat，内容按写缓冲区空间分段读入
+  int file_fd = -1;
+  bool borrowed = false; // 描述符借自事件循环的描述符缓存，不能关闭
+  bool is_regular = false;
+  size_t file_size = 0;
+  struct timespec mtime = {};
+  if (info->ring_file_io) {
+    if (info->file_op.state != UringFileOpState::READY) {
+      // 请求暂停，OPENAT+STATX完成后同一个请求会被再次处理
+      info->request_file_open(file_path);
+      return;
+    }
+    const struct statx &stx = info->file_op.stx;
+    bool stat_ok = info->file_op.stat_result == 0;
+    borrowed = info->file_op.borrowed();
+    file_fd = info->file_op.take_fd();
+    if (file_fd >= 0 && stat_ok && S_ISREG(stx.stx_mode)) {
+      is_regular = true;
+      file_size = stx.stx_size;
+      mtime.tv_sec = stx.stx_mtime.tv_sec;
+      mtime.tv_nsec = stx.stx_mtime.tv_nsec;
+    }
+  } else {
+    file_fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat file_stat;
+    if (file_fd >= 0 && fstat(file_fd, &file_stat) == 0 &&
+        S_ISREG(file_stat.st_mode)) {
+      is_regular = true;
+      file_size = file_stat.st_size;
+      mtime = file_stat.st_mtim;
+    }
+  }
+  if (!is_regular) {
+    if (file_fd >= 0 && !borrowed) {
+      close(file_fd);
+    }
+    // 文件不存在，发送404响应
+    send_not_found(info);
+    return;
+  }
 
-      request_.headers[key] = value;
+  // 不缓存的大文件不做内容哈希，用"长度-修改时间"作为ETag，在读文件之前判断
+  char etag[48];
+  int etag_size = std::snprintf(
+      etag, sizeof(etag), "\"%zx-%llx\"", file_size,
+      static_cast<unsigned long long>(mtime.tv_sec) * 1000000000ULL +
+          mtime.tv_nsec);
+  char validators[kValidatorsMaxSize];
+  size_t validators_size = http_format_validators(
+      validators, std::string_view(etag, etag_size), mtime.tv_sec);
+  if (is_not_modified(std::string_view(etag, etag_size), mtime.tv_sec)) {
+    if (!borrowed) {
+      close(file_fd);
+    }
+    send_not_modified(info, std::string_view(validators, validators_size));
+    return;
+  }
 
-      // 处理Content-Length
-      if (key == "Content-Length") {
-        try {
-          request_.content_length = std::stoul(std::string(value));
-        } catch (const std::exception &e) {
-          return false;
-        }
-      }
+  HttpResponse response;
+  response.status = HttpStatus::OK;
+  response.content_type = http_mime_from_path(file_path);
+  response.set_content_length(file_size);
+  if (request_.headers.contains(HttpHeaderId::RANGE)) {
+    HttpRangeSource source;
+    source.mime = response.content_type;
+    source.size = file_size;
+    source.etag = std::string_view(etag, etag_size);
+    source.last_modified = mtime.tv_sec;
+    source.fd = file_fd;
+    source.borrowed = borrowed;
+    if (send_range_response(info, source)) {
+      return;
+    }
+  }
 
-      // 处理Transfer-Encoding
-      if (key == "Transfer-Encoding" && value == "chunked") {
-        request_.is_chunked = true;
+  char date[kHttpDateSize];
+  http_format_date(date, mtime.tv_sec);
+  response.add_header("ETag", std::string_view(etag, etag_size));
+  response.add_header("Last-Modified", std::string_view(date, sizeof(date)));
+  response.add_header("Accept-Ranges", "bytes");
+
+  if (info->ring_file_io) {
+    // 响应体由事件循环分段READ进写缓冲区，链接的WRITE写出
+    if (send_simple_response(info, response)) {
+      info->file_stream.start(file_fd, 0, file_size);
+      if (borrowed) {
+        info->file_stream.borrow_from(info->file_op);
       }
+    } else if (!borrowed) {
+      close(file_fd);
     }
+    return;
+  }
 
-    if (line_end == headers_data.length())
-      break;
-    line_start = line_end + 2;
+  void *memory = mr_->allocate(sizeof(FileBodyProducer),
+                               alignof(FileBodyProducer));
+  send_stream_response(info, response, new (memory) FileBodyProducer(file_fd));
+}
+
+// 发送缓存的文件响应
+template <typename Entry, typename Variant>
+void HttpTask::send_cached_response(UringConnectionInfo *info,
+                                    const std::shared_ptr<const Entry> &entry,
+                                    const Variant &variant) {
+  HttpResponse response;
+  response.keep_alive = info->keep_alive;
+  response.preformatted = variant.headers;
+  bool inline_body =
+      variant.body.size() <= STATIC_CACHE_INLINE_BODY &&
+      HttpResponseWriter::header_size(response) + variant.body.size() <=
+          info->write_buffer.get_writable_size();
+  if (inline_body) {
+    response.body = variant.body;
+  }
+  if (!send_simple_response(info, response)) {
+    return;
+  }
+  if (!inline_body) {
+    // 响应体不进写缓冲区，写出前连接持有条目引用，淘汰不影响发送
+    info->set_output_segment(entry, variant.body);
   }
+}
 
-  parse_state_.headers_parsed = true;
-  return true;
+template <typename Entry>
+ContentEncoding HttpTask::choose_encoding(const Entry &entry) const {
+  // 范围请求只针对原始内容
+  if (!request_.headers.contains(HttpHeaderId::ACCEPT_ENCODING) ||
+      request_.headers.contains(HttpHeaderId::RANGE)) {
+    return ContentEncoding::IDENTITY;
+  }
+  std::string_view accept =
+      request_.headers.get(HttpHeaderId::ACCEPT_ENCODING);
+  int star = accept_encoding_quality(accept, "*", 0);
+  ContentEncoding best = ContentEncoding::IDENTITY;
+  int best_quality = 0;
+  // 同等q值时优先brotli
+  for (ContentEncoding encoding :
+       {ContentEncoding::BROTLI, ContentEncoding::GZIP}) {
+    if (!entry.has_variant(encoding)) {
+      continue;
+    }
+    int quality = accept_encoding_quality(
+        accept, encoding == ContentEncoding::BROTLI ? "br" : "gzip", star);
+    if (quality > best_quality) {
+      best = encoding;
+      best_quality = quality;
+    }
+  }
+  return best;
 }
 
-// 解析请求体
-bool HttpTask::parse_request_body(std::string_view data) {
-  size_t body_start = data.find("\r\n\r\n") + 4;
+// 发送内存中的静态文件（缓存条目或归档文件）
+template <typename Entry>
+void HttpTask::send_static_entry(UringConnectionInfo *info,
+                                 const std::shared_ptr<const Entry> &entry) {
+  const auto &variant = entry->variant(choose_encoding(*entry));
+  // 条件请求命中时不碰文件，直接回复304
+  if (is_not_modified(variant.etag, entry->last_modified)) {
+    send_not_modified(info, variant.validators());
+    return;
+  }
+  if (request_.headers.contains(HttpHeaderId::RANGE)) {
+    HttpRangeSource source;
+    source.mime = entry->mime;
+    source.size = variant.body.size();
+    source.etag = variant.etag;
+    source.last_modified = entry->last_modified;
+    source.data = variant.body;
+    source.owner = entry;
+    if (send_range_response(info, source)) {
+      return;
+    }
+  }
+  send_cached_response(info, entry, variant);
+}
 
-  if (request_.content_length > 0) {
-    if (data.length() - body_start >= request_.content_length) {
-      request_.body = data.substr(body_start, request_.content_length);
-      parse_state_.body_parsed = true;
-      return true;
+// 发送静态文件
+void HttpTask::send_static_file(UringConnectionInfo *info,
+                                std::string_view path) {
+  const StaticArchive &archive = StaticArchive::instance();
+  if (archive.mapped()) {
+    // 归档模式：只查归档的完美哈希索引，不碰文件系统
+    StaticArchive::FilePtr file = archive.find(path);
+    if (file) {
+      send_static_entry(info, file);
+    } else {
+      send_not_found(info);
     }
-    return false;
+    return;
+  }
+  // 索引中没有的路径一定不存在：不查缓存也不碰文件系统
+  if (!StaticPathIndex::instance().may_exist(path)) {
+    send_not_found(info);
+    return;
+  }
+  StaticFileCache &cache = StaticFileCache::instance();
+  if (!info->ring_file_io) {
+    StaticFileCache::EntryPtr entry = cache.get(path);
+    if (entry) {
+      send_static_entry(info, entry);
+      return;
+    }
+    // 文件不存在或太大，直接读文件（由它给出404或流式响应）
+    std::pmr::string file_path(HTTP_STATIC_ROOT, mr_);
+    file_path.append(path);
+    send_file_response(info, file_path);
+    return;
   }
 
-  // 没有请求体的情况
-  parse_state_.body_parsed = true;
-  return true;
+  // 由事件循环驱动：工作线程不读文件。未命中时在环上打开文件，可缓存的
+  // 小文件同时整个读入；结果就绪后重新处理时不再查缓存，直接用环上的结果
+  UringFileOp &op = info->file_op;
+  if (op.state != UringFileOpState::READY) {
+    StaticFileCache::EntryPtr entry = cache.find(path);
+    if (entry) {
+      send_static_entry(info, entry);
+      return;
+    }
+    std::pmr::string file_path(HTTP_STATIC_ROOT, mr_);
+    file_path.append(path);
+    info->request_file_open(file_path, STATIC_CACHE_MAX_ENTRY);
+    return;
+  }
+  if (op.body_ready) {
+    int64_t mtime =
+        static_cast<int64_t>(op.stx.stx_mtime.tv_sec) * 1000000000 +
+        op.stx.stx_mtime.tv_nsec;
+    StaticFileCache::EntryPtr entry =
+        cache.fill(std::string(path), std::move(op.body), mtime);
+    if (entry) {
+      // 打开的描述符没有用到，由handle_message复位时关闭（或归还缓存）
+      send_static_entry(info, entry);
+      return;
+    }
+  }
+  // 文件不存在或太大：用打开的描述符给出404或在环上流式读出
+  std::pmr::string file_path(HTTP_STATIC_ROOT, mr_);
+  file_path.append(path);
+  send_file_response(info, file_path);
 }
 
-// 发送简单响应
-void HttpTask::send_simple_response(UringConnectionInfo *info,
-                                    const HttpResponse &response) {
-  std::string headers_str;
-  for (const auto &header : response.headers) {
-    headers_str += header.first + ": " + header.second + "\r\n";
-  }
-
-  // 构建完整的HTTP响应
-  std::string full_response = response.response_line + headers_str + "\r\n";
-
-  // 将响应头写入缓冲区
-  size_t header_size = full_response.size();
-  size_t body_size = response.body.size();
-  size_t total_size = header_size + body_size;
-
-  // 确保写缓冲区有足够空间
-  if (info->write_buffer.get_writable_size() >= total_size) {
-    // 写入响应头
-    char *write_tail = info->write_buffer.get_write_tail();
-    std::memcpy(write_tail, full_response.c_str(), header_size);
-    info->write_buffer.write_data(header_size);
-
-    // 写入响应体
-    if (body_size > 0) {
-      write_tail = info->write_buffer.get_write_tail();
-      std::memcpy(write_tail, response.body.data(), body_size);
-      info->write_buffer.write_data(body_size);
-    }
-
-    std::cout << "HTTP响应已写入缓冲区，总大小: " << total_size
-              << "字节（头:" << header_size << "字节，体:" << body_size
-              << "字节）" << std::endl;
-    std::cout << "响应状态行: " << response.response_line;
-  } else {
-    std::cerr << "写缓冲区空间不足，需要" << total_size << "字节，可用"
-              << info->write_buffer.get_writable_size() << "字节" << std::endl;
+// 处理简单任务
+HttpRouter<HttpTask::Route> HttpTask::build_routes() {
+  HttpRouter<Route> router;
+  auto add = [&router](HttpMethod method, std::string_view pattern,
+                       RouteHandler handler, HttpRoutePolicy policy,
+                       BodySinkFactory body_sink = nullptr) {
+    if (!router.add(method, pattern, Route{handler, policy, body_sink})) {
+      size_t index = static_cast<size_t>(method);
+      std::cerr << "路由注册失败: " << kHttpMethodNames[index] << " "
+                << pattern << std::endl;
+    }
+  };
+  add(HttpMethod::GET, "/", &HttpTask::handle_root, HttpRoutePolicy::INLINE);
+  add(HttpMethod::GET, "/health", &HttpTask::handle_health,
+      HttpRoutePolicy::INLINE);
+  // 其他GET路径都按静态文件处理，静态路由和参数路由优先于它
+  add(HttpMethod::GET, "/*path", &HttpTask::handle_static,
+      HttpRoutePolicy::INLINE_IF_CACHED);
+  // 遥测上报：换行分隔的记录，chunked请求体边解码边统计
+  add(HttpMethod::POST, "/telemetry", &HttpTask::handle_telemetry,
+      HttpRoutePolicy::INLINE, &make_body_sink<HttpTelemetrySink>);
+  add(HttpMethod::POST, "/*path", &HttpTask::handle_post,
+      HttpRoutePolicy::INLINE);
+  return router;
+}
+
+const HttpRouter<HttpTask::Route> &HttpTask::routes() {
+  static const HttpRouter<Route> router = build_routes();
+  return router;
+}
+
+bool HttpTask::is_static_in_memory(UringConnectionInfo *info,
+                                   std::string_view url) {
+  std::pmr::string path(info->arena.resource());
+  if (!http_normalize_path(url, path)) {
+    return true;
+  }
+  if (StaticArchive::instance().mapped()) {
+    return true;
   }
+  return !StaticPathIndex::instance().may_exist(path) ||
+         StaticFileCache::instance().resident(path);
 }
 
-// 发送文件响应（零拷贝）
-void HttpTask::send_file_response(UringConnectionInfo *info,
-                                  const std::string &file_path) {
-  // 这里应该使用sendfile或splice等零拷贝技术
-  // 简化实现：读取文件到缓冲区
-  std::ifstream file(file_path, std::ios::binary | std::ios::ate);
-  if (!file.is_open()) {
-    // 文件不存在，发送404响应
-    HttpResponse response;
-    response.response_line = "HTTP/1.1 404 Not Found\r\n";
-    std::string body_str = "Not Found";
-    response.body.assign(body_str.begin(), body_str.end());
-    response.headers["Content-Type"] = "text/plain; charset=utf-8";
-    response.headers["Content-Length"] = std::to_string(response.body.size());
-    send_simple_response(info, response);
-    return;
+const HttpTask::Route *HttpTask::find_route(UringConnectionInfo *info) {
+  const char *base = info->read_buffer.get_read_head();
+  std::string_view url = info->parser.url(base);
+  HttpRouteParams params;
+  uint32_t allowed;
+  return routes().find(http_method_from(info->parser.method(base)),
+                       url.substr(0, url.find('?')), params, allowed);
+}
+
+bool HttpTask::can_run_inline(UringConnectionInfo *info) {
+  if (info->parse_result != ParseResult::COMPLETE) {
+    return true;
+  }
+  if (info->file_op.state == UringFileOpState::READY) {
+    return false;
   }
+  const Route *route = find_route(info);
+  if (!route) {
+    return true;
+  }
+  switch (route->policy) {
+  case HttpRoutePolicy::INLINE:
+    return true;
+  case HttpRoutePolicy::INLINE_IF_CACHED:
+    return is_static_in_memory(
+        info, info->parser.url(info->read_buffer.get_read_head()));
+  case HttpRoutePolicy::BLOCKING:
+    break;
+  }
+  return false;
+}
 
-  size_t file_size = file.tellg();
-  file.seekg(0);
+void HttpTask::handle_root(UringConnectionInfo *info, const HttpRouteParams &) {
+  HttpResponse response;
+  response.content_type = HttpMime::PLAIN;
+  response.set_body("Hello World!");
+  send_simple_response(info, response);
+}
 
+void HttpTask::handle_health(UringConnectionInfo *info,
+                             const HttpRouteParams &) {
   HttpResponse response;
-  response.response_line = "HTTP/1.1 200 OK\r\n";
-  response.headers["Content-Length"] = std::to_string(file_size);
-
-  // 根据文件扩展名设置Content-Type
-  size_t dot_pos = file_path.find_last_of('.');
-  if (dot_pos != std::string::npos) {
-    std::string ext = file_path.substr(dot_pos + 1);
-    if (ext == "html" || ext == "htm") {
-      response.headers["Content-Type"] = "text/html; charset=utf-8";
-    } else if (ext == "css") {
-      response.headers["Content-Type"] = "text/css; charset=utf-8";
-    } else if (ext == "js") {
-      response.headers["Content-Type"] = "application/javascript";
-    } else if (ext == "png") {
-      response.headers["Content-Type"] = "image/png";
-    } else if (ext == "jpg" || ext == "jpeg") {
-      response.headers["Content-Type"] = "image/jpeg";
-    }
-  }
-
-  // 读取文件内容
-  response.body.resize(file_size);
-  file.read(response.body.data(), file_size);
+  response.content_type = HttpMime::PLAIN;
+  response.set_body("OK");
+  send_simple_response(info, response);
+}
 
+void HttpTask::handle_static(UringConnectionInfo *info,
+                             const HttpRouteParams &) {
+  // 规范化用完整URL（含%XX和查询串），不用已切分的参数
+  std::pmr::string path(mr_);
+  if (http_normalize_path(request_.url, path)) {
+    send_static_file(info, path);
+    return;
+  }
+  HttpResponse response;
+  response.status = HttpStatus::BAD_REQUEST;
+  response.content_type = HttpMime::PLAIN;
+  response.set_body("Bad Request");
   send_simple_response(info, response);
 }
 
-// 处理简单任务
-void HttpTask::handle_task(UringConnectionInfo *info) {
+void HttpTask::handle_post(UringConnectionInfo *info, const HttpRouteParams &) {
   HttpResponse response;
+  response.content_type = HttpMime::PLAIN;
+  response.set_body("POST received");
+  send_simple_response(info, response);
+}
 
-  if (request_.method == "GET") {
-    // 处理根路径
-    if (request_.url == "/") {
-      response.response_line = "HTTP/1.1 200 OK\r\n";
-      std::string body_str = "Hello World!";
-      response.body.assign(body_str.begin(), body_str.end());
-    }
-    // 处理健康检查
-    else if (request_.url == "/health") {
-      response.response_line = "HTTP/1.1 200 OK\r\n";
-      std::string body_str = "OK";
-      response.body.assign(body_str.begin(), body_str.end());
-    }
-    // 处理静态文件
-    else {
-      std::string file_path = "../../html" + std::string(request_.url);
-      send_file_response(info, file_path);
-      return;
-    }
-  } else if (request_.method == "POST") {
-    response.response_line = "HTTP/1.1 200 OK\r\n";
-    std::string body_str = "POST received";
-    response.body.assign(body_str.begin(), body_str.end());
+void HttpTask::handle_telemetry(UringConnectionInfo *info,
+                                const HttpRouteParams &) {
+  HttpTelemetrySink local;
+  HttpTelemetrySink *sink = &local;
+  if (request_.is_chunked) {
+    // 请求体已在解码时交付给本路由创建的接收端
+    sink = static_cast<HttpTelemetrySink *>(info->body_sink);
   } else {
-    response.response_line = "HTTP/1.1 405 Method Not Allowed\r\n";
-    std::string body_str = "Method Not Allowed";
-    response.body.assign(body_str.begin(), body_str.end());
+    local.on_data(request_.body.segment(0));
+    local.on_data(request_.body.segment(1));
+    local.on_complete();
+  }
+  char body[64];
+  int length = std::snprintf(body, sizeof(body), "accepted %zu records",
+                             sink->records());
+  HttpResponse response;
+  response.content_type = HttpMime::PLAIN;
+  response.set_body(std::string_view(body, static_cast<size_t>(length)));
+  send_simple_response(info, response);
+}
+
+void HttpTask::handle_task(UringConnectionInfo *info) {
+  std::string_view path = request_.url.substr(0, request_.url.find('?'));
+  HttpRouteParams params;
+  uint32_t allowed;
+  const Route *route = routes().find(http_method_from(request_.method), path,
+                                     params, allowed);
+  if (route) {
+    (this->*route->handler)(info, params);
+    return;
   }
 
-  response.headers["Content-Type"] = "text/plain; charset=utf-8";
-  response.headers["Content-Length"] = std::to_string(response.body.size());
+  HttpResponse response;
+  response.content_type = HttpMime::PLAIN;
+  char allow[HTTP_ALLOW_LINE_SIZE];
+  if (allowed != 0) {
+    // 路径存在但不支持该方法，Allow列出可用的方法
+    response.status = HttpStatus::METHOD_NOT_ALLOWED;
+    response.set_body("Method Not Allowed");
+    size_t allow_size = http_format_allow(allow, allowed);
+    response.add_header("Allow", std::string_view(allow, allow_size));
+  } else {
+    response.status = HttpStatus::NOT_FOUND;
+    response.set_body("Not Found");
+  }
   send_simple_response(info, response);
 }
 // 主处理函数
@@ -299,68 +812,81 @@ bool HttpTask::handle_message(UringConnectionInfo *info) {
   std::cout << "http处理主函数--------httpcpp" << std::endl;
   ParseResult result = info->parse_result;
   switch (result) {
-  case ParseResult::CHUNKED_UNSUPPORTED: {
-    // 不支持chunked编码
-    info->parse_result = ParseResult::CHUNKED_UNSUPPORTED;
-    HttpResponse chunked_response;
-    chunked_response.response_line = "HTTP/1.1 501 Not Implemented\r\n";
-    chunked_response.body = {'C', 'h', 'u', 'n', 'k', 'e', 'd', ' ', 'e', 'n',
-                             'c', 'o', 'd', 'i', 'n', 'g', ' ', 'n', 'o', 't',
-                             ' ', 's', 'u', 'p', 'p', 'o', 'r', 't', 'e', 'd'};
-    chunked_response.headers["Content-Length"] =
-        std::to_string(chunked_response.body.size());
-    send_simple_response(info, chunked_response);
+  case ParseResult::PAYLOAD_TOO_LARGE: {
+    // 请求体超过上限：剩余数据无法可靠跳过，响应后关闭连接
+    HttpResponse large_response;
+    large_response.status = HttpStatus::PAYLOAD_TOO_LARGE;
+    large_response.content_type = HttpMime::PLAIN;
+    large_response.set_body("Payload Too Large");
+    info->keep_alive = false;
+    send_simple_response(info, large_response);
+    info->read_buffer.read_data(info->read_buffer.get_readable_size());
+    info->close_body_sink();
+    info->parser.reset();
+    info->parse_result = ParseResult::NEEED_MORE_DATA;
+    return true;
+  }
+  case ParseResult::INVALID_FORMAT: {
+    // 报文格式错误
+    HttpResponse bad_response;
+    bad_response.status = HttpStatus::BAD_REQUEST;
+    bad_response.content_type = HttpMime::PLAIN;
+    bad_response.set_body("Bad Request");
+    info->keep_alive = false;
+    send_simple_response(info, bad_response);
+    info->read_buffer.read_data(info->read_buffer.get_readable_size());
+    info->close_body_sink();
+    info->parser.reset();
+    info->parse_result = ParseResult::NEEED_MORE_DATA;
     return true;
-    break;
   }
   case ParseResult::COMPLETE: {
-    // 报文完整，开始解析
-    std::string request_data;
+    // 报文完整，解析器已经记录了各部分区间，这里不再重新扫描
+    // 请求直接引用读缓冲区和额外缓冲区，处理结束前两者都不释放
     char *read_head = info->read_buffer.get_read_head();
     size_t read_size = info->read_buffer.get_readable_size();
-    if (info->extra_buffer != nullptr) {
-      // 拼接数据
-      std::string_view second_data(info->extra_buffer, info->bytes_NO_read);
-      request_data = std::string(read_head, read_size);
-      request_data.append(second_data.begin(), second_data.end());
-    } else {
-      request_data = std::string(read_head, read_size);
-    }
-    // 解析请求行
-    if (!parse_request_line(request_data)) {
-      return false;
+    std::string_view overflow;
+    if (info->extra_buffer_in_use) {
+      overflow = std::string_view(info->extra_buffer, info->bytes_NO_read);
     }
+    populate_request(info->parser, read_head, read_size, overflow);
 
-    // 解析请求头
-    if (!parse_request_headers(request_data)) {
-      return false;
+    // 决定本次响应后是否保持连接（文件打开后重新处理的请求已经计过数）
+    if (info->file_op.state != UringFileOpState::READY) {
+      info->requests_served++;
     }
-
-    // 解析请求体
-    if (!parse_request_body(request_data)) {
-      return false;
+    if (!request_keeps_alive(request_) ||
+        info->requests_served >= HTTP_MAX_KEEPALIVE_REQUESTS) {
+      info->keep_alive = false;
     }
     handle_task(info);
 
+    if (info->file_op.pending()) {
+      // 文件在环上打开：请求留在读缓冲区，解析状态保持完整，结果就绪后重新处理
+      return true;
+    }
+    // 重新处理时命中了缓存等情况，没有用到已打开的文件
+    info->file_op.reset();
+
     // 处理完成后，重置parse_result为需要更多数据，准备处理下一个请求
     info->parse_result = ParseResult::NEEED_MORE_DATA;
 
-    // 释放extra_buffer这里只是将info的指针置空，实际内存由内存池管理
-    if (info->extra_buffer != nullptr) {
-      info->extra_buffer = nullptr;
-      info->extra_buffer_in_use = false;
-      info->bytes_NO_read = 0;
-    }
+    // 额外缓冲区不再被引用，由分发器在处理结束后归还内存池
+    info->extra_buffer_in_use = false;
+    info->close_body_sink();
+    info->bytes_NO_read = 0;
 
     // 打印请求数据
-    std::cout << "http____----request_data:" << request_data << std::endl;
+    std::cout << "http____----request: " << request_.method << " "
+              << request_.url << std::endl;
     // 打印回应数据
     std::cout << "http____-----response_data:"
               << info->write_buffer.get_readable_size() << std::endl;
-    // 处理完成后，从读缓冲区移除已处理的数据
+    // 处理完成后，从读缓冲区移除已处理的数据，解析器复位
     size_t total_processed =
-        request_data.find("\r\n\r\n") + 4 + request_.content_length;
+        std::min(info->parser.message_length(), read_size);
     info->read_buffer.read_data(total_processed);
+    info->parser.reset();
     return true;
   }
   default:
@@ -392,7 +918,30 @@ bool HttpTask::is_http_parse_complete(UringConnectionInfo *info) {
     return true;
   }
   ParseResult result = is_complete_message(info);
-  return result == ParseResult::COMPLETE;
+  if (result == ParseResult::NEEED_MORE_DATA) {
+    return false;
+  }
+  // 完整或无法继续解析（格式错误、不支持的编码）都交给handle_message给出响应
+  info->parse_result = result;
+  return true;
+}
+
+// 静态方法：流水线中的下一个请求
+bool HttpTask::has_pipelined_request(UringConnectionInfo *info) {
+  // 连接即将关闭，之后的请求不再处理
+  if (!info->keep_alive || info->read_buffer.is_empty()) {
+    return false;
+  }
+  // 流式响应、外部数据或文件流还没写出，后续响应要排在它之后，由写完成事件继续
+  if (info->response_stream.active() || !info->output_segment.empty() ||
+      info->file_stream.active() || info->file_op.pending()) {
+    return false;
+  }
+  if (!info->write_buffer.is_empty() &&
+      info->write_buffer.get_writable_size() < HTTP_PIPELINE_MIN_WRITE_SPACE) {
+    return false;
+  }
+  return is_http_parse_complete(info);
 }
 
 // 静态方法：处理HTTP请求（带回调版本）
@@ -0,0 +1,462 @@
+#include "http_parser.h"
+#include "http_scan.h"
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+// RFC 9110 token字符表：方法名与头部名只允许这些字符
+struct TokenTable {
+  bool table[256] = {};
+  constexpr TokenTable() {
+    for (int c = '0'; c <= '9'; ++c)
+      table[c] = true;
+    for (int c = 'a'; c <= 'z'; ++c)
+      table[c] = true;
+    for (int c = 'A'; c <= 'Z'; ++c)
+      table[c] = true;
+    for (char c : std::string_view("!#$%&'*+-.^_`|~"))
+      table[static_cast<unsigned char>(c)] = true;
+  }
+};
+constexpr TokenTable kTokenTable;
+
+inline bool is_token(char c) {
+  return kTokenTable.table[static_cast<unsigned char>(c)];
+}
+
+// 去掉列表元素两侧的空白（OWS）
+std::string_view trim_ows(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+} // namespace
+
+void HttpParser::reset() {
+  state_ = State::METHOD;
+  pos_ = 0;
+  token_start_ = 0;
+  value_end_ = 0;
+  header_end_ = 0;
+  method_ = url_ = version_ = current_name_ = HttpSpan();
+  header_count_ = 0;
+  content_length_ = 0;
+  chunked_ = false;
+  has_content_length_ = false;
+  has_transfer_encoding_ = false;
+  chunk_state_ = ChunkState::SIZE;
+  chunk_remaining_ = 0;
+  chunk_digits_ = 0;
+  chunk_line_bytes_ = 0;
+  body_length_ = 0;
+}
+
+bool HttpParser::finish_header(const char *base) {
+  if (header_count_ >= HTTP_MAX_HEADERS) {
+    return false;
+  }
+  HttpSpan value{static_cast<uint32_t>(token_start_),
+                 static_cast<uint32_t>(value_end_ - token_start_)};
+  HttpHeaderId id = http_header_id(current_name_.view(base));
+  headers_[header_count_++] = HttpHeaderSpan{current_name_, value, id};
+
+  std::string_view text = value.view(base);
+  if (id == HttpHeaderId::CONTENT_LENGTH) {
+    // 同时带Transfer-Encoding、或多个Content-Length取值不同，都无法确定
+    // 报文边界（请求走私），直接拒绝
+    if (has_transfer_encoding_) {
+      return false;
+    }
+    size_t length = 0;
+    auto result =
+        std::from_chars(text.data(), text.data() + text.size(), length);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size() ||
+        (has_content_length_ && length != content_length_)) {
+      return false;
+    }
+    has_content_length_ = true;
+    content_length_ = length;
+  } else if (id == HttpHeaderId::TRANSFER_ENCODING) {
+    if (has_content_length_) {
+      return false;
+    }
+    has_transfer_encoding_ = true;
+    return parse_transfer_codings(text);
+  }
+  return true;
+}
+
+bool HttpParser::parse_transfer_codings(std::string_view text) {
+  // 逗号分隔的编码列表，多个Transfer-Encoding头部按顺序接成一个列表；
+  // chunked只能出现一次且必须是最后一个，是否最后要等头部结束才知道
+  while (!text.empty()) {
+    size_t comma = text.find(',');
+    std::string_view coding = trim_ows(text.substr(0, comma));
+    text = comma == std::string_view::npos ? std::string_view()
+                                           : text.substr(comma + 1);
+    if (coding.empty()) {
+      continue; // 列表允许空元素
+    }
+    if (chunked_) {
+      return false; // chunked之后还有编码
+    }
+    std::string_view name = trim_ows(coding.substr(0, coding.find(';')));
+    if (name.empty() || !std::all_of(name.begin(), name.end(), is_token)) {
+      return false;
+    }
+    chunked_ = http_iequals(coding, "chunked");
+  }
+  return true;
+}
+
+void HttpParser::finish_headers() {
+  // 当前字节是空行的\n，请求体从下一个字节开始
+  header_end_ = pos_ + 1;
+  // 最后一个传输编码不是chunked时无法确定请求体边界
+  if (has_transfer_encoding_ && !chunked_) {
+    state_ = State::ERROR;
+    return;
+  }
+  if (!chunked_ && content_length_ > HTTP_MAX_BODY_SIZE) {
+    state_ = State::TOO_LARGE;
+    return;
+  }
+  state_ = (chunked_ || content_length_ > 0) ? State::BODY : State::DONE;
+}
+
+ParseResult HttpParser::execute_chunked(const char *base, size_t size,
+                                        HttpBodySink *sink) {
+  while (pos_ < size) {
+    char c = base[pos_];
+    switch (chunk_state_) {
+    case ChunkState::SIZE: {
+      int digit = -1;
+      if (c >= '0' && c <= '9') {
+        digit = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        digit = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        digit = c - 'A' + 10;
+      }
+      if (digit >= 0) {
+        // 限制位数，防止长度溢出
+        if (++chunk_digits_ > 15) {
+          state_ = State::ERROR;
+          return ParseResult::INVALID_FORMAT;
+        }
+        chunk_remaining_ = chunk_remaining_ * 16 + digit;
+      } else if (chunk_digits_ == 0) {
+        state_ = State::ERROR;
+        return ParseResult::INVALID_FORMAT;
+      } else if (c == ';' || c == ' ' || c == '\t') {
+        chunk_state_ = ChunkState::EXTENSION;
+      } else if (c == '\r') {
+        chunk_state_ = ChunkState::SIZE_LF;
+      } else {
+        state_ = State::ERROR;
+        return ParseResult::INVALID_FORMAT;
+      }
+      ++pos_;
+      break;
+    }
+
+    case ChunkState::EXTENSION:
+      ++chunk_line_bytes_;
+      if (c == '\r') {
+        chunk_state_ = ChunkState::SIZE_LF;
+      } else if (c == '\n') {
+        state_ = State::ERROR;
+        return ParseResult::INVALID_FORMAT;
+      }
+      ++pos_;
+      break;
+
+    case ChunkState::SIZE_LF:
+      if (c != '\n') {
+        state_ = State::ERROR;
+        return ParseResult::INVALID_FORMAT;
+      }
+      ++pos_;
+      chunk_digits_ = 0;
+      chunk_line_bytes_ = 0;
+      if (chunk_remaining_ == 0) {
+        chunk_state_ = ChunkState::TRAILER;
+      } else if (body_length_ + chunk_remaining_ > HTTP_MAX_STREAM_BODY_SIZE) {
+        state_ = State::TOO_LARGE;
+        return ParseResult::PAYLOAD_TOO_LARGE;
+      } else {
+        chunk_state_ = ChunkState::DATA;
+      }
+      break;
+
+    case ChunkState::DATA: {
+      // 数据段直接从读缓冲区交付，不拷贝
+      size_t n = std::min(chunk_remaining_, size - pos_);
+      if (sink) {
+        sink->on_data(std::string_view(base + pos_, n));
+      }
+      pos_ += n;
+      body_length_ += n;
+      chunk_remaining_ -= n;
+      if (chunk_remaining_ == 0) {
+        chunk_state_ = ChunkState::DATA_CR;
+      }
+      break;
+    }
+
+    case ChunkState::DATA_CR:
+    case ChunkState::DATA_LF:
+      if (c != (chunk_state_ == ChunkState::DATA_CR ? '\r' : '\n')) {
+        state_ = State::ERROR;
+        return ParseResult::INVALID_FORMAT;
+      }
+      chunk_state_ = chunk_state_ == ChunkState::DATA_CR ? ChunkState::DATA_LF
+                                                         : ChunkState::SIZE;
+      ++pos_;
+      break;
+
+    case ChunkState::TRAILER:
+      chunk_state_ = c == '\r' ? ChunkState::END_LF : ChunkState::TRAILER_LINE;
+      ++pos_;
+      break;
+
+    case ChunkState::TRAILER_LINE:
+      ++chunk_line_bytes_;
+      if (c == '\n') {
+        chunk_state_ = ChunkState::TRAILER;
+      }
+      ++pos_;
+      break;
+
+    case ChunkState::END_LF:
+      if (c != '\n') {
+        state_ = State::ERROR;
+        return ParseResult::INVALID_FORMAT;
+      }
+      ++pos_;
+      state_ = State::DONE;
+      if (sink) {
+        sink->on_complete();
+      }
+      return ParseResult::COMPLETE;
+    }
+
+    // 被忽略的扩展与trailer也要限制长度
+    if (chunk_line_bytes_ > HTTP_MAX_HEADER_BYTES) {
+      state_ = State::ERROR;
+      return ParseResult::INVALID_FORMAT;
+    }
+  }
+  return ParseResult::NEEED_MORE_DATA;
+}
+
+size_t HttpParser::release_chunked_input() {
+  if (!chunked_ || !headers_complete()) {
+    return 0;
+  }
+  size_t released = pos_ - header_end_;
+  pos_ = header_end_;
+  return released;
+}
+
+ParseResult HttpParser::execute(const char *base, size_t size,
+                                HttpBodySink *sink) {
+  while (pos_ < size && state_ != State::BODY && state_ != State::DONE) {
+    char c = base[pos_];
+    switch (state_) {
+    case State::METHOD:
+      if (c == ' ') {
+        if (pos_ == token_start_) {
+          state_ = State::ERROR;
+          break;
+        }
+        method_ = HttpSpan{static_cast<uint32_t>(token_start_),
+                           static_cast<uint32_t>(pos_ - token_start_)};
+        token_start_ = pos_ + 1;
+        state_ = State::URL;
+      } else if (!is_token(c)) {
+        state_ = State::ERROR;
+      }
+      break;
+
+    case State::URL: {
+      // 批量跳过普通字符，停在空格或非法字符上
+      size_t skip = http_scan(base + pos_, size - pos_, ' ');
+      pos_ += skip;
+      if (pos_ == size) {
+        continue;
+      }
+      c = base[pos_];
+      if (c == ' ') {
+        if (pos_ == token_start_) {
+          state_ = State::ERROR;
+          break;
+        }
+        url_ = HttpSpan{static_cast<uint32_t>(token_start_),
+                        static_cast<uint32_t>(pos_ - token_start_)};
+        token_start_ = pos_ + 1;
+        state_ = State::VERSION;
+      } else {
+        state_ = State::ERROR;
+      }
+      break;
+    }
+
+    case State::VERSION: {
+      size_t skip = http_scan(base + pos_, size - pos_, '\r');
+      pos_ += skip;
+      if (pos_ == size) {
+        continue;
+      }
+      c = base[pos_];
+      if (c == '\r' || c == '\n') {
+        version_ = HttpSpan{static_cast<uint32_t>(token_start_),
+                            static_cast<uint32_t>(pos_ - token_start_)};
+        if (version_.view(base).substr(0, 5) != "HTTP/") {
+          state_ = State::ERROR;
+          break;
+        }
+        state_ = c == '\r' ? State::REQUEST_LINE_LF : State::HEADER_LINE_START;
+      } else {
+        state_ = State::ERROR;
+      }
+      break;
+    }
+
+    case State::REQUEST_LINE_LF:
+    case State::HEADER_LINE_LF:
+      state_ = c == '\n' ? State::HEADER_LINE_START : State::ERROR;
+      break;
+
+    case State::HEADER_LINE_START:
+      if (c == '\r') {
+        state_ = State::HEADERS_END_LF;
+      } else if (c == '\n') {
+        finish_headers();
+      } else if (is_token(c)) {
+        token_start_ = pos_;
+        state_ = State::HEADER_NAME;
+      } else {
+        state_ = State::ERROR;
+      }
+      break;
+
+    case State::HEADER_NAME: {
+      // 先定位冒号，再校验跳过的部分都是token字符
+      size_t skip = http_scan(base + pos_, size - pos_, ':');
+      for (size_t i = 0; i < skip; ++i) {
+        if (!is_token(base[pos_ + i])) {
+          state_ = State::ERROR;
+          break;
+        }
+      }
+      pos_ += skip;
+      if (state_ == State::ERROR) {
+        break;
+      }
+      if (pos_ == size) {
+        continue;
+      }
+      c = base[pos_];
+      if (c == ':') {
+        current_name_ = HttpSpan{static_cast<uint32_t>(token_start_),
+                                 static_cast<uint32_t>(pos_ - token_start_)};
+        state_ = State::HEADER_VALUE_START;
+      } else {
+        state_ = State::ERROR;
+      }
+      break;
+    }
+
+    case State::HEADER_VALUE_START:
+      if (c == ' ' || c == '\t') {
+        break;
+      }
+      token_start_ = pos_;
+      state_ = State::HEADER_VALUE;
+      continue; // 当前字节按头部值重新处理
+
+    case State::HEADER_VALUE: {
+      // 批量跳到行尾（\r \n都是控制字符）
+      size_t skip = http_scan(base + pos_, size - pos_, '\r');
+      pos_ += skip;
+      if (pos_ == size) {
+        continue;
+      }
+      c = base[pos_];
+      if (c != '\r' && c != '\n') {
+        state_ = State::ERROR;
+        break;
+      }
+      // 去掉值尾部的空白
+      value_end_ = pos_;
+      while (value_end_ > token_start_ &&
+             (base[value_end_ - 1] == ' ' || base[value_end_ - 1] == '\t')) {
+        --value_end_;
+      }
+      if (!finish_header(base)) {
+        state_ = State::ERROR;
+        break;
+      }
+      state_ = c == '\r' ? State::HEADER_LINE_LF : State::HEADER_LINE_START;
+      break;
+    }
+
+    case State::HEADERS_END_LF:
+      if (c != '\n') {
+        state_ = State::ERROR;
+        break;
+      }
+      finish_headers();
+      break;
+
+    default:
+      break;
+    }
+
+    if (state_ == State::ERROR) {
+      return ParseResult::INVALID_FORMAT;
+    }
+    if (state_ == State::TOO_LARGE) {
+      return ParseResult::PAYLOAD_TOO_LARGE;
+    }
+    ++pos_;
+  }
+
+  if (state_ == State::ERROR) {
+    return ParseResult::INVALID_FORMAT;
+  }
+  if (state_ == State::TOO_LARGE) {
+    return ParseResult::PAYLOAD_TOO_LARGE;
+  }
+  if (state_ == State::BODY) {
+    if (chunked_) {
+      // 没有接收端时停在请求体起点
+      if (!sink) {
+        return ParseResult::NEEED_MORE_DATA;
+      }
+      return execute_chunked(base, size, sink);
+    }
+    // 请求体不逐字节扫描，只比较已到达的长度
+    if (size - header_end_ < content_length_) {
+      return ParseResult::NEEED_MORE_DATA;
+    }
+    state_ = State::DONE;
+    pos_ = message_length();
+  }
+  if (state_ == State::DONE) {
+    return ParseResult::COMPLETE;
+  }
+  // 头部还没结束，限制头部总长度
+  if (pos_ > HTTP_MAX_HEADER_BYTES) {
+    state_ = State::ERROR;
+    return ParseResult::INVALID_FORMAT;
+  }
+  return ParseResult::NEEED_MORE_DATA;
+}
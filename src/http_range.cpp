@@ -0,0 +1,240 @@
+#include "http_range.h"
+#include "http_headers.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+// 全部是数字才成功，溢出也视为失败
+bool parse_size(std::string_view text, size_t &value) {
+  if (text.empty()) {
+    return false;
+  }
+  auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+  return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+size_t append(char *out, size_t pos, std::string_view piece) {
+  std::memcpy(out + pos, piece.data(), piece.size());
+  return pos + piece.size();
+}
+
+// "\r\n--boundary\r\nContent-Type: ...\r\n"
+// "Content-Range: bytes a-b/size\r\n\r\n"
+size_t format_part_header(char *out, HttpMime mime,
+                          const HttpByteRange &range, size_t size) {
+  size_t pos = append(out, 0, "\r\n--");
+  pos = append(out, pos, kByterangesBoundary);
+  pos = append(out, pos, "\r\n");
+  pos = append(out, pos, http_content_type_line(mime));
+  pos = append(out, pos, "Content-Range: ");
+  pos += http_format_content_range(out + pos, range, size);
+  return append(out, pos, "\r\n\r\n");
+}
+
+// "\r\n--boundary--\r\n"
+size_t format_closing(char *out) {
+  size_t pos = append(out, 0, "\r\n--");
+  pos = append(out, pos, kByterangesBoundary);
+  return append(out, pos, "--\r\n");
+}
+
+} // namespace
+
+HttpRangeResult http_parse_ranges(std::string_view header, size_t size,
+                                  HttpByteRange *ranges, size_t &count) {
+  count = 0;
+  header = trim(header);
+  if (header.size() < 6 || !http_iequals(header.substr(0, 5), "bytes") ||
+      header[5] != '=') {
+    return HttpRangeResult::NONE;
+  }
+  header.remove_prefix(6);
+
+  bool any_spec = false;
+  while (!header.empty()) {
+    size_t comma = header.find(',');
+    std::string_view spec = trim(header.substr(0, comma));
+    header = comma == std::string_view::npos ? std::string_view()
+                                             : header.substr(comma + 1);
+    if (spec.empty()) {
+      continue;
+    }
+    size_t dash = spec.find('-');
+    if (dash == std::string_view::npos) {
+      return HttpRangeResult::NONE;
+    }
+    any_spec = true;
+
+    HttpByteRange range;
+    if (dash == 0) {
+      // 后缀范围：最后n个字节
+      size_t suffix;
+      if (!parse_size(spec.substr(1), suffix)) {
+        return HttpRangeResult::NONE;
+      }
+      if (suffix == 0 || size == 0) {
+        continue;
+      }
+      range.first = size - std::min(suffix, size);
+      range.last = size - 1;
+    } else {
+      size_t first;
+      size_t last = size - 1;
+      if (!parse_size(spec.substr(0, dash), first)) {
+        return HttpRangeResult::NONE;
+      }
+      std::string_view last_text = spec.substr(dash + 1);
+      if (!last_text.empty()) {
+        if (!parse_size(last_text, last) || last < first) {
+          return HttpRangeResult::NONE;
+        }
+      }
+      if (first >= size) {
+        continue;
+      }
+      range.first = first;
+      range.last = std::min(last, size - 1);
+    }
+    if (count == HTTP_MAX_RANGES) {
+      return HttpRangeResult::NONE;
+    }
+    ranges[count++] = range;
+  }
+
+  if (!any_spec) {
+    return HttpRangeResult::NONE;
+  }
+  return count > 0 ? HttpRangeResult::SATISFIABLE
+                   : HttpRangeResult::UNSATISFIABLE;
+}
+
+size_t http_format_content_range(char *out, const HttpByteRange &range,
+                                 size_t size) {
+  char *p = out;
+  char *end = out + kContentRangeMaxSize;
+  std::memcpy(p, "bytes ", 6);
+  p += 6;
+  p = std::to_chars(p, end, range.first).ptr;
+  *p++ = '-';
+  p = std::to_chars(p, end, range.last).ptr;
+  *p++ = '/';
+  p = std::to_chars(p, end, size).ptr;
+  return p - out;
+}
+
+HttpRangeBodyProducer::HttpRangeBodyProducer(HttpRangeSource source,
+                                             const HttpByteRange *ranges,
+                                             size_t count)
+    : source_(std::move(source)),
+      count_(std::min<size_t>(count, HTTP_MAX_RANGES)), index_(0), offset_(0),
+      multipart_(count_ > 1), header_size_(0), header_pos_(0) {
+  std::copy(ranges, ranges + count_, ranges_);
+  prepare_header();
+}
+
+HttpRangeBodyProducer::~HttpRangeBodyProducer() {
+  if (source_.fd >= 0 && !source_.borrowed) {
+    close(source_.fd);
+  }
+}
+
+void HttpRangeBodyProducer::prepare_header() {
+  header_pos_ = 0;
+  if (!multipart_) {
+    header_size_ = 0;
+  } else if (index_ < count_) {
+    header_size_ = format_part_header(header_, source_.mime, ranges_[index_],
+                                      source_.size);
+  } else {
+    header_size_ = format_closing(header_);
+  }
+}
+
+size_t HttpRangeBodyProducer::body_length(const HttpRangeSource &source,
+                                          const HttpByteRange *ranges,
+                                          size_t count) {
+  if (count == 1) {
+    return ranges[0].length();
+  }
+  char header[HTTP_RANGE_PART_HEADER_SIZE];
+  size_t length = format_closing(header);
+  for (size_t i = 0; i < count; ++i) {
+    length += format_part_header(header, source.mime, ranges[i], source.size);
+    length += ranges[i].length();
+  }
+  return length;
+}
+
+size_t HttpRangeBodyProducer::produce(char *out, size_t capacity,
+                                      bool &finished) {
+  size_t written = 0;
+  while (written < capacity) {
+    if (header_pos_ < header_size_) {
+      size_t n = std::min(capacity - written, header_size_ - header_pos_);
+      std::memcpy(out + written, header_ + header_pos_, n);
+      header_pos_ += n;
+      written += n;
+      continue;
+    }
+    if (index_ == count_) {
+      finished = true;
+      break;
+    }
+
+    const HttpByteRange &range = ranges_[index_];
+    size_t n = std::min(capacity - written, range.length() - offset_);
+    size_t position = range.first + offset_;
+    if (source_.fd >= 0) {
+      ssize_t result = pread(source_.fd, out + written, n, position);
+      if (result <= 0) {
+        // 文件被截断，剩下的内容无法补齐
+        finished = true;
+        break;
+      }
+      n = static_cast<size_t>(result);
+    } else {
+      std::memcpy(out + written, source_.data.data() + position, n);
+    }
+    offset_ += n;
+    written += n;
+    if (offset_ == range.length()) {
+      ++index_;
+      offset_ = 0;
+      prepare_header();
+    }
+  }
+  return written;
+}
+
+void HttpRangeParts::start(HttpMime mime, size_t size,
+                           const HttpByteRange *ranges, size_t count) {
+  mime_ = mime;
+  size_ = size;
+  count_ = std::min<size_t>(count, HTTP_MAX_RANGES);
+  index_ = 0;
+  std::copy(ranges, ranges + count_, ranges_);
+}
+
+bool HttpRangeParts::next(char *out, size_t &written, HttpByteRange &range) {
+  if (index_ < count_) {
+    range = ranges_[index_++];
+    written = format_part_header(out, mime_, range, size_);
+    return true;
+  }
+  ++index_;
+  written = format_closing(out);
+  return false;
+}
@@ -0,0 +1,223 @@
+#include "http_response.h"
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+constexpr char kWeekdays[7][4] = {"Sun", "Mon", "Tue", "Wed",
+                                  "Thu", "Fri", "Sat"};
+constexpr char kMonths[12][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+inline char *write_2digits(char *p, int value) {
+  p[0] = static_cast<char>('0' + value / 10);
+  p[1] = static_cast<char>('0' + value % 10);
+  return p + 2;
+}
+
+inline int parse_2digits(const char *p) {
+  if (p[0] < '0' || p[0] > '9' || p[1] < '0' || p[1] > '9') {
+    return -1;
+  }
+  return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+// "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"，不依赖locale
+void format_date_line(char *p, time_t now) {
+  std::memcpy(p, "Date: ", 6);
+  http_format_date(p + 6, now);
+  std::memcpy(p + 6 + kHttpDateSize, "\r\n", 2);
+}
+
+// Content-Length的十进制位数
+inline size_t decimal_digits(size_t value) {
+  size_t digits = 1;
+  while (value >= 10) {
+    value /= 10;
+    ++digits;
+  }
+  return digits;
+}
+
+} // namespace
+
+
+void http_format_date(char *p, time_t time) {
+  struct tm tm;
+  gmtime_r(&time, &tm);
+  std::memcpy(p, kWeekdays[tm.tm_wday], 3);
+  p += 3;
+  *p++ = ',';
+  *p++ = ' ';
+  p = write_2digits(p, tm.tm_mday);
+  *p++ = ' ';
+  std::memcpy(p, kMonths[tm.tm_mon], 3);
+  p += 3;
+  *p++ = ' ';
+  int year = tm.tm_year + 1900;
+  p = write_2digits(p, year / 100);
+  p = write_2digits(p, year % 100);
+  *p++ = ' ';
+  p = write_2digits(p, tm.tm_hour);
+  *p++ = ':';
+  p = write_2digits(p, tm.tm_min);
+  *p++ = ':';
+  p = write_2digits(p, tm.tm_sec);
+  std::memcpy(p, " GMT", 4);
+}
+
+size_t http_format_validators(char *out, std::string_view etag,
+                              time_t last_modified) {
+  char *p = out;
+  std::memcpy(p, "ETag: ", 6);
+  p += 6;
+  std::memcpy(p, etag.data(), etag.size());
+  p += etag.size();
+  std::memcpy(p, "\r\nLast-Modified: ", 17);
+  p += 17;
+  http_format_date(p, last_modified);
+  p += kHttpDateSize;
+  std::memcpy(p, "\r\n", 2);
+  return p + 2 - out;
+}
+
+bool http_parse_date(std::string_view text, time_t &time) {
+  // "Sun, 06 Nov 1994 08:49:37 GMT"，各字段位置固定
+  if (text.size() != kHttpDateSize || text.substr(3, 2) != ", " ||
+      text[7] != ' ' || text[11] != ' ' || text[16] != ' ' ||
+      text[19] != ':' || text[22] != ':' || text.substr(25) != " GMT") {
+    return false;
+  }
+  const char *p = text.data();
+  struct tm tm = {};
+  tm.tm_mon = -1;
+  for (int i = 0; i < 12; ++i) {
+    if (std::memcmp(p + 8, kMonths[i], 3) == 0) {
+      tm.tm_mon = i;
+      break;
+    }
+  }
+  int century = parse_2digits(p + 12);
+  int year = parse_2digits(p + 14);
+  tm.tm_mday = parse_2digits(p + 5);
+  tm.tm_hour = parse_2digits(p + 17);
+  tm.tm_min = parse_2digits(p + 20);
+  tm.tm_sec = parse_2digits(p + 23);
+  if (tm.tm_mon < 0 || century < 0 || year < 0 || tm.tm_mday < 1 ||
+      tm.tm_hour < 0 || tm.tm_min < 0 || tm.tm_sec < 0) {
+    return false;
+  }
+  tm.tm_year = century * 100 + year - 1900;
+  time = timegm(&tm);
+  return true;
+}
+
+HttpMime http_mime_from_path(std::string_view path) {
+  size_t dot_pos = path.find_last_of('.');
+  if (dot_pos == std::string_view::npos) {
+    return HttpMime::OCTET_STREAM;
+  }
+  std::string_view ext = path.substr(dot_pos + 1);
+  if (ext == "html" || ext == "htm") {
+    return HttpMime::HTML;
+  } else if (ext == "css") {
+    return HttpMime::CSS;
+  } else if (ext == "js") {
+    return HttpMime::JAVASCRIPT;
+  } else if (ext == "png") {
+    return HttpMime::PNG;
+  } else if (ext == "jpg" || ext == "jpeg") {
+    return HttpMime::JPEG;
+  } else if (ext == "txt") {
+    return HttpMime::PLAIN;
+  }
+  return HttpMime::OCTET_STREAM;
+}
+
+HttpDateCache::HttpDateCache() : current_(0), second_(0) {
+  time_t now = std::time(nullptr);
+  format_date_line(slots_[0].line, now);
+  second_.store(now, std::memory_order_relaxed);
+}
+
+HttpDateCache &HttpDateCache::instance() {
+  static HttpDateCache cache;
+  return cache;
+}
+
+void HttpDateCache::update(time_t now) {
+  if (now == second_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  // 只有事件循环线程调用，写到下一个槽后再发布
+  size_t next = (current_.load(std::memory_order_relaxed) + 1) % HTTP_DATE_SLOTS;
+  format_date_line(slots_[next].line, now);
+  second_.store(now, std::memory_order_relaxed);
+  current_.store(next, std::memory_order_release);
+}
+
+void HttpResponseWriter::append(std::string_view piece) {
+  if (overflow_ || piece.size() > capacity_ - size_) {
+    overflow_ = true;
+    return;
+  }
+  if (piece.empty()) {
+    return;
+  }
+  std::memcpy(out_ + size_, piece.data(), piece.size());
+  size_ += piece.size();
+}
+
+size_t HttpResponseWriter::header_size(const HttpResponse &response) {
+  size_t size = http_status_line(response.status).size() + kDateLineSize +
+                (response.keep_alive ? kConnectionKeepAliveLine.size()
+                                     : kConnectionCloseLine.size()) +
+                2;
+  if (!response.preformatted.empty()) {
+    size += response.preformatted.size();
+  } else {
+    size += http_content_type_line(response.content_type).size();
+    if (response.framing == HttpBodyFraming::CONTENT_LENGTH) {
+      size += kContentLengthPrefix.size() +
+              decimal_digits(response.content_length) + 2;
+    } else if (response.framing == HttpBodyFraming::CHUNKED) {
+      size += kChunkedEncodingLine.size();
+    }
+  }
+  for (size_t i = 0; i < response.extra_count; ++i) {
+    size += response.extra_headers[i].first.size() + 2 +
+            response.extra_headers[i].second.size() + 2;
+  }
+  return size;
+}
+
+void HttpResponseWriter::write_headers(const HttpResponse &response) {
+  append(http_status_line(response.status));
+  append(HttpDateCache::instance().line());
+
+  if (!response.preformatted.empty()) {
+    append(response.preformatted);
+  } else {
+    append(http_content_type_line(response.content_type));
+    if (response.framing == HttpBodyFraming::CONTENT_LENGTH) {
+      char digits[24];
+      auto result = std::to_chars(digits, digits + sizeof(digits),
+                                  response.content_length);
+      append(kContentLengthPrefix);
+      append(std::string_view(digits, result.ptr - digits));
+      append("\r\n");
+    } else if (response.framing == HttpBodyFraming::CHUNKED) {
+      append(kChunkedEncodingLine);
+    }
+  }
+
+  append(response.keep_alive ? kConnectionKeepAliveLine
+                             : kConnectionCloseLine);
+  for (size_t i = 0; i < response.extra_count; ++i) {
+    append(response.extra_headers[i].first);
+    append(": ");
+    append(response.extra_headers[i].second);
+    append("\r\n");
+  }
+  append("\r\n");
+}
@@ -0,0 +1,170 @@
+#include "http_router.h"
+#include <algorithm>
+#include <cstring>
+
+size_t http_format_allow(char *out, uint32_t methods) {
+  size_t pos = 0;
+  for (size_t i = 0; i < HTTP_METHOD_COUNT; ++i) {
+    if (!(methods & http_method_bit(static_cast<HttpMethod>(i)))) {
+      continue;
+    }
+    if (pos > 0) {
+      std::memcpy(out + pos, ", ", 2);
+      pos += 2;
+    }
+    std::memcpy(out + pos, kHttpMethodNames[i].data(),
+                kHttpMethodNames[i].size());
+    pos += kHttpMethodNames[i].size();
+  }
+  return pos;
+}
+
+HttpRouteTree::Node::Node() {
+  std::fill(routes, routes + HTTP_METHOD_COUNT, -1);
+}
+
+HttpRouteTree::Node *HttpRouteTree::insert_static(Node *node,
+                                                  std::string_view text) {
+  while (!text.empty()) {
+    size_t index = node->indices.find(text[0]);
+    if (index == std::string::npos) {
+      auto child = std::make_unique<Node>();
+      child->prefix = std::string(text);
+      node->indices.push_back(text[0]);
+      node->children.push_back(std::move(child));
+      return node->children.back().get();
+    }
+
+    Node *child = node->children[index].get();
+    size_t common = 0;
+    size_t limit = std::min(child->prefix.size(), text.size());
+    while (common < limit && child->prefix[common] == text[common]) {
+      ++common;
+    }
+    if (common < child->prefix.size()) {
+      // 拆分：公共前缀成为新节点，原节点挂在它下面
+      auto split = std::make_unique<Node>();
+      split->prefix = child->prefix.substr(0, common);
+      child->prefix.erase(0, common);
+      split->indices.push_back(child->prefix[0]);
+      split->children.push_back(std::move(node->children[index]));
+      node->children[index] = std::move(split);
+      child = node->children[index].get();
+    }
+    text.remove_prefix(common);
+    node = child;
+  }
+  return node;
+}
+
+bool HttpRouteTree::insert(HttpMethod method, std::string_view pattern,
+                           int32_t route) {
+  if (method == HttpMethod::UNKNOWN || pattern.empty() || pattern[0] != '/') {
+    return false;
+  }
+  Node *node = &root_;
+  size_t param_count = 0;
+  while (!pattern.empty()) {
+    size_t special = pattern.find_first_of(":*");
+    node = insert_static(node, pattern.substr(0, special));
+    if (special == std::string_view::npos) {
+      break;
+    }
+    if (++param_count > HTTP_ROUTE_MAX_PARAMS) {
+      return false;
+    }
+
+    bool is_catch_all = pattern[special] == '*';
+    size_t end = is_catch_all ? pattern.size() : pattern.find('/', special);
+    if (end == std::string_view::npos) {
+      end = pattern.size();
+    }
+    std::string_view name = pattern.substr(special + 1, end - special - 1);
+    if (name.empty() || name.find_first_of(":*/") != std::string_view::npos) {
+      return false;
+    }
+
+    std::unique_ptr<Node> &slot = is_catch_all ? node->catch_all : node->param;
+    if (!slot) {
+      slot = std::make_unique<Node>();
+      slot->name = std::string(name);
+    } else if (slot->name != name) {
+      // 同一位置的参数必须同名，否则匹配结果有歧义
+      return false;
+    }
+    node = slot.get();
+    pattern.remove_prefix(end);
+  }
+
+  int32_t &slot = node->routes[static_cast<size_t>(method)];
+  if (slot >= 0) {
+    return false;
+  }
+  slot = route;
+  node->methods |= http_method_bit(method);
+  return true;
+}
+
+bool HttpRouteTree::match_here(const Node *node, HttpMethod method,
+                               int32_t &route, uint32_t &allowed) {
+  if (node->methods == 0) {
+    return false;
+  }
+  if (allowed == 0) {
+    allowed = node->methods;
+  }
+  if (method == HttpMethod::UNKNOWN) {
+    return false;
+  }
+  route = node->routes[static_cast<size_t>(method)];
+  return route >= 0;
+}
+
+bool HttpRouteTree::match(const Node *node, std::string_view path,
+                          HttpMethod method, HttpRouteParams &params,
+                          int32_t &route, uint32_t &allowed) {
+  if (path.empty()) {
+    if (match_here(node, method, route, allowed)) {
+      return true;
+    }
+  } else {
+    size_t index = node->indices.find(path[0]);
+    if (index != std::string::npos) {
+      const Node *child = node->children[index].get();
+      if (path.compare(0, child->prefix.size(), child->prefix) == 0 &&
+          match(child, path.substr(child->prefix.size()), method, params,
+                route, allowed)) {
+        return true;
+      }
+    }
+    // 参数匹配一个非空路径段
+    if (node->param && path[0] != '/') {
+      size_t end = std::min(path.find('/'), path.size());
+      params.push(node->param->name, path.substr(0, end));
+      if (match(node->param.get(), path.substr(end), method, params, route,
+                allowed)) {
+        return true;
+      }
+      params.pop();
+    }
+  }
+  if (node->catch_all) {
+    params.push(node->catch_all->name, path);
+    if (match_here(node->catch_all.get(), method, route, allowed)) {
+      return true;
+    }
+    params.pop();
+  }
+  return false;
+}
+
+int32_t HttpRouteTree::find(HttpMethod method, std::string_view path,
+                            HttpRouteParams &params, uint32_t &allowed) const {
+  params.clear();
+  allowed = 0;
+  int32_t route = -1;
+  if (!match(&root_, path, method, params, route, allowed)) {
+    return -1;
+  }
+  return route;
+}
@@ -0,0 +1,158 @@
+#include "http_scan.h"
+#include <atomic>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCAN_X86 1
+#endif
+
+namespace {
+
+inline bool needs_attention(char c, char delim) {
+  unsigned char u = static_cast<unsigned char>(c);
+  return (u < 0x20 && u != '\t') || u == 0x7f || c == delim;
+}
+
+size_t scan_scalar(const char *data, size_t size, char delim) {
+  for (size_t i = 0; i < size; ++i) {
+    if (needs_attention(data[i], delim)) {
+      return i;
+    }
+  }
+  return size;
+}
+
+#ifdef HTTP_SCAN_X86
+// SSE4.2：pcmpestri范围模式，4个区间 [00-08] [0a-1f] [7f-7f] [delim-delim]
+__attribute__((target("sse4.2"))) size_t
+scan_sse42(const char *data, size_t size, char delim) {
+  alignas(16) char ranges[16] = {'\x00', '\x08', '\x0a', '\x1f',
+                                 '\x7f', '\x7f', delim,  delim};
+  const __m128i range_vec =
+      _mm_load_si128(reinterpret_cast<const __m128i *>(ranges));
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    int index = _mm_cmpestri(range_vec, 8, block, 16,
+                             _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES |
+                                 _SIDD_LEAST_SIGNIFICANT);
+    if (index != 16) {
+      return i + index;
+    }
+  }
+  return i + scan_scalar(data + i, size - i, delim);
+}
+
+// AVX2：v <= 0x1f 且 v != '\t'，或 v == 0x7f，或 v == delim
+__attribute__((target("avx2"))) size_t scan_avx2(const char *data, size_t size,
+                                                 char delim) {
+  const __m256i ctl_max = _mm256_set1_epi8(0x1f);
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  const __m256i delim_vec = _mm256_set1_epi8(delim);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    __m256i is_ctl =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(block, ctl_max), block);
+    is_ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(block, tab), is_ctl);
+    __m256i hit = _mm256_or_si256(
+        is_ctl, _mm256_or_si256(_mm256_cmpeq_epi8(block, del),
+                                _mm256_cmpeq_epi8(block, delim_vec)));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + scan_scalar(data + i, size - i, delim);
+}
+#endif
+
+using ScanFn = size_t (*)(const char *, size_t, char);
+
+ScanFn kernel_function(HttpScanKernel kernel) {
+  switch (kernel) {
+#ifdef HTTP_SCAN_X86
+  case HttpScanKernel::SSE42:
+    return scan_sse42;
+  case HttpScanKernel::AVX2:
+    return scan_avx2;
+#endif
+  default:
+    return scan_scalar;
+  }
+}
+
+// CPU支持的最快内核
+HttpScanKernel select_kernel() {
+  if (http_scan_kernel_supported(HttpScanKernel::AVX2)) {
+    return HttpScanKernel::AVX2;
+  }
+  if (http_scan_kernel_supported(HttpScanKernel::SSE42)) {
+    return HttpScanKernel::SSE42;
+  }
+  return HttpScanKernel::SCALAR;
+}
+
+// 当前内核的扫描函数：首次使用时在静态变量初始化中选择（事件循环和
+// 工作线程同时首次调用也只选择一次），之后只有http_scan_set_kernel修改
+std::atomic<ScanFn> &active_scan() {
+  static std::atomic<ScanFn> scan{kernel_function(select_kernel())};
+  return scan;
+}
+
+} // namespace
+
+size_t http_scan(const char *data, size_t size, char delim) {
+  return active_scan().load(std::memory_order_relaxed)(data, size, delim);
+}
+
+HttpScanKernel http_scan_kernel() {
+  // 按扫描函数反查内核；不支持SIMD的平台上各内核都映射到标量实现
+  ScanFn scan = active_scan().load(std::memory_order_relaxed);
+  for (HttpScanKernel kernel : {HttpScanKernel::SCALAR, HttpScanKernel::SSE42,
+                                HttpScanKernel::AVX2}) {
+    if (kernel_function(kernel) == scan) {
+      return kernel;
+    }
+  }
+  return HttpScanKernel::SCALAR;
+}
+
+bool http_scan_kernel_supported(HttpScanKernel kernel) {
+  switch (kernel) {
+  case HttpScanKernel::SCALAR:
+    return true;
+#ifdef HTTP_SCAN_X86
+  case HttpScanKernel::SSE42:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+  case HttpScanKernel::AVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+bool http_scan_set_kernel(HttpScanKernel kernel) {
+  if (!http_scan_kernel_supported(kernel)) {
+    return false;
+  }
+  active_scan().store(kernel_function(kernel), std::memory_order_relaxed);
+  return true;
+}
+
+const char *http_scan_kernel_name(HttpScanKernel kernel) {
+  switch (kernel) {
+  case HttpScanKernel::SSE42:
+    return "sse4.2";
+  case HttpScanKernel::AVX2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
@@ -0,0 +1,103 @@
+#include "http_stream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kChunkHeaderSize = 8; // 6位十六进制长度 + \r\n
+constexpr size_t kChunkTrailerSize = 2; // 数据后的\r\n
+constexpr char kLastChunk[] = "0\r\n\r\n";
+constexpr size_t kLastChunkSize = sizeof(kLastChunk) - 1;
+
+// 固定宽度的分块长度（允许前导0），先预留位置再回填，数据不用挪动
+void write_chunk_header(char *out, size_t length) {
+  static const char kHex[] = "0123456789abcdef";
+  for (int i = 5; i >= 0; --i) {
+    out[i] = kHex[length & 0xf];
+    length >>= 4;
+  }
+  out[6] = '\r';
+  out[7] = '\n';
+}
+
+} // namespace
+
+void HttpResponseStream::start(HttpBodyProducer *producer,
+                               HttpBodyFraming framing,
+                               size_t content_length) {
+  producer_ = producer;
+  framing_ = framing;
+  remaining_ = content_length;
+  truncated_ = false;
+  finished_ = framing == HttpBodyFraming::CONTENT_LENGTH && remaining_ == 0;
+}
+
+size_t HttpResponseStream::pump_once(char *out, size_t capacity) {
+  bool done = false;
+  switch (framing_) {
+  case HttpBodyFraming::CONTENT_LENGTH: {
+    size_t n = producer_->produce(out, std::min(capacity, remaining_), done);
+    n = std::min(n, remaining_);
+    remaining_ -= n;
+    if (remaining_ == 0) {
+      finished_ = true;
+    } else if (done || n == 0) {
+      // 已经发出的Content-Length无法更改，只能关闭连接
+      finished_ = true;
+      truncated_ = true;
+    }
+    return n;
+  }
+
+  case HttpBodyFraming::CHUNKED: {
+    // 预留分块头、分块尾和结束块的位置
+    size_t reserved = kChunkHeaderSize + kChunkTrailerSize + kLastChunkSize;
+    if (capacity <= reserved) {
+      return 0;
+    }
+    size_t limit = std::min(capacity - reserved, size_t(HTTP_STREAM_MAX_CHUNK));
+    size_t n = producer_->produce(out + kChunkHeaderSize, limit, done);
+    size_t written = 0;
+    if (n > 0) {
+      write_chunk_header(out, n);
+      std::memcpy(out + kChunkHeaderSize + n, "\r\n", kChunkTrailerSize);
+      written = kChunkHeaderSize + n + kChunkTrailerSize;
+    }
+    if (done || n == 0) {
+      std::memcpy(out + written, kLastChunk, kLastChunkSize);
+      written += kLastChunkSize;
+      finished_ = true;
+    }
+    return written;
+  }
+
+  case HttpBodyFraming::UNTIL_CLOSE: {
+    size_t n = producer_->produce(out, capacity, done);
+    if (done || n == 0) {
+      finished_ = true;
+    }
+    return n;
+  }
+  }
+  return 0;
+}
+
+size_t HttpResponseStream::pump(char *out, size_t capacity) {
+  size_t written = 0;
+  while (active() && !finished_ && capacity - written >= HTTP_STREAM_MIN_SPACE) {
+    size_t n = pump_once(out + written, capacity - written);
+    if (n == 0 && !finished_) {
+      break;
+    }
+    written += n;
+  }
+  return written;
+}
+
+void HttpResponseStream::close() {
+  if (producer_) {
+    producer_->~HttpBodyProducer();
+    producer_ = nullptr;
+  }
+  finished_ = false;
+}
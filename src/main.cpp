@@ -1,3 +1,8 @@
+#include "http_complete.h"
+#include "static_archive.h"
+#include "static_file_cache.h"
+#include "static_path_index.h"
+#include "uring_preloader.h"
 #include "uring_server.h"
 #include <csignal>
 #include <iostream>
@@ -21,6 +26,44 @@ int main() {
   try {
     std::cout << "启动IO_URING服务器..." << std::endl;
 
+    // 启动前构建路由表，工作线程之后只读
+    std::cout << "已注册路由: " << HttpTask::routes().size() << "条"
+              << std::endl;
+
+#if STATIC_ARCHIVE_ENABLED
+    // 归档模式：映射已有的归档，没有或无效时先打包
+    // 静态文件更新后删除归档文件，下次启动时重新打包
+    StaticArchive &archive = StaticArchive::instance();
+    if (archive.open(STATIC_ARCHIVE_FILE) ||
+        (StaticArchive::pack(HTTP_STATIC_ROOT, STATIC_ARCHIVE_FILE) &&
+         archive.open(STATIC_ARCHIVE_FILE))) {
+      std::cout << "静态归档已映射: " << archive.size() << "个文件, "
+                << archive.mapped_bytes() << "字节" << std::endl;
+    } else {
+      std::cerr << "静态归档不可用，改用静态文件缓存" << std::endl;
+    }
+#endif
+    if (!StaticArchive::instance().mapped()) {
+      // 启动前在环上批量读入静态文件并生成压缩版本，请求路径上不再压缩
+      UringPreloader preloader(StaticFileCache::instance());
+      if (preloader.init()) {
+        preloader.run();
+        const UringPreloader::Stats &stats = preloader.stats();
+        std::cout << "静态文件预加载完成: " << stats.loaded << "/"
+                  << stats.files << "个文件, " << stats.bytes << "字节, "
+                  << stats.submits << "次提交, 读取" << stats.read_ms
+                  << "ms, 共" << stats.total_ms << "ms" << std::endl;
+      } else {
+        size_t preloaded = StaticFileCache::instance().preload();
+        std::cout << "静态文件预加载完成: " << preloaded << "个文件"
+                  << std::endl;
+      }
+
+      // 已有文件的索引，不存在的路径直接404
+      size_t indexed = StaticPathIndex::instance().build();
+      std::cout << "静态路径索引: " << indexed << "个文件" << std::endl;
+    }
+
     // 创建服务器实例
     IoUringServer server(2025); // 使用2025端口
     g_server = &server;
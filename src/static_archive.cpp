@@ -0,0 +1,323 @@
+#include "static_archive.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kArchiveMagic[8] = {'S', 'T', 'P', 'A', 'C', 'K', '0', '1'};
+constexpr size_t kVariantCount = static_cast<size_t>(ContentEncoding::COUNT);
+// 每个桶尝试的第二级种子上限，超过时放弃打包
+constexpr uint32_t kMaxSeed = 1u << 24;
+
+// 以下结构按原样写入归档，只在同一台机器上生成和读取
+struct ArchiveHeader {
+  char magic[8];
+  uint32_t count;   // 文件数，也是槽位数
+  uint32_t buckets; // 第一级桶数
+  uint64_t seeds_offset;
+  uint64_t entries_offset;
+  uint64_t size; // 归档总长
+};
+
+struct ArchiveSpan {
+  uint64_t offset;
+  uint64_t size;
+};
+
+struct ArchiveVariant {
+  ArchiveSpan headers;
+  ArchiveSpan body;
+  ArchiveSpan etag;
+  uint64_t validators_offset;
+};
+
+struct ArchiveEntry {
+  ArchiveSpan path;
+  ArchiveVariant variants[kVariantCount];
+  int64_t last_modified;
+  uint32_t mime;
+  uint32_t reserved;
+};
+
+size_t align_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+ArchiveSpan append_span(std::string &out, std::string_view data) {
+  ArchiveSpan span = {out.size(), data.size()};
+  out.append(data);
+  return span;
+}
+
+bool write_file(const std::string &path, std::string_view data) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = write(fd, data.data() + written, data.size() - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    written += n;
+  }
+  bool ok = written == data.size() && fsync(fd) == 0;
+  close(fd);
+  return ok;
+}
+
+} // namespace
+
+StaticArchive &StaticArchive::instance() {
+  static StaticArchive archive;
+  return archive;
+}
+
+// 写进归档的索引依赖这个哈希，不能用实现相关的std::hash
+uint64_t StaticArchive::hash(std::string_view path, uint64_t seed) {
+  uint64_t h = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+  for (char c : path) {
+    h ^= static_cast<uint8_t>(c);
+    h *= 0x100000001b3ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+bool StaticArchive::pack(const std::string &root,
+                         const std::string &archive_path) {
+  StaticFileCache loader(root, 0);
+  std::vector<std::pair<std::string, StaticFileCache::EntryPtr>> files;
+  for (std::string &path : loader.list_files()) {
+    if (StaticFileCache::EntryPtr entry = loader.read_entry(path)) {
+      files.emplace_back(std::move(path), std::move(entry));
+    }
+  }
+  if (files.empty()) {
+    // 根目录不存在或读不了时不生成空归档，否则所有请求都是404
+    std::cerr << "静态根目录下没有可打包的文件: " << root << std::endl;
+    return false;
+  }
+
+  // 最小完美哈希：大桶先放，每桶找一个让桶内路径落到互不冲突空槽的种子
+  uint32_t count = static_cast<uint32_t>(files.size());
+  uint32_t buckets = std::max<uint32_t>(
+      1, (count + STATIC_ARCHIVE_BUCKET_SIZE - 1) / STATIC_ARCHIVE_BUCKET_SIZE);
+  std::vector<std::vector<uint32_t>> members(buckets);
+  for (uint32_t i = 0; i < count; ++i) {
+    members[hash(files[i].first, 0) % buckets].push_back(i);
+  }
+  std::vector<uint32_t> order(buckets);
+  for (uint32_t b = 0; b < buckets; ++b) {
+    order[b] = b;
+  }
+  std::sort(order.begin(), order.end(), [&members](uint32_t a, uint32_t b) {
+    return members[a].size() > members[b].size();
+  });
+
+  std::vector<uint32_t> seeds(buckets, 0);
+  std::vector<int64_t> slot_of(count, -1); // 文件 -> 槽位
+  std::vector<bool> taken(count, false);
+  std::vector<uint32_t> slots;
+  for (uint32_t bucket : order) {
+    if (members[bucket].empty()) {
+      break;
+    }
+    uint32_t seed = 1;
+    for (; seed < kMaxSeed; ++seed) {
+      slots.clear();
+      for (uint32_t file : members[bucket]) {
+        uint32_t slot = hash(files[file].first, seed) % count;
+        if (taken[slot] ||
+            std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (slots.size() == members[bucket].size()) {
+        break;
+      }
+    }
+    if (seed == kMaxSeed) {
+      std::cerr << "静态归档的完美哈希构造失败" << std::endl;
+      return false;
+    }
+    seeds[bucket] = seed;
+    for (size_t i = 0; i < slots.size(); ++i) {
+      taken[slots[i]] = true;
+      slot_of[members[bucket][i]] = slots[i];
+    }
+  }
+
+  // 头部、种子和条目表，之后是字符串，最后是对齐的响应体
+  std::string out(sizeof(ArchiveHeader), '\0');
+  ArchiveHeader header = {};
+  std::memcpy(header.magic, kArchiveMagic, sizeof(kArchiveMagic));
+  header.count = count;
+  header.buckets = buckets;
+  header.seeds_offset = out.size();
+  out.append(reinterpret_cast<const char *>(seeds.data()),
+             seeds.size() * sizeof(uint32_t));
+  out.resize(align_up(out.size(), alignof(ArchiveEntry)));
+  header.entries_offset = out.size();
+  out.resize(out.size() + count * sizeof(ArchiveEntry));
+
+  std::vector<ArchiveEntry> entries(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const StaticCacheEntry &entry = *files[i].second;
+    ArchiveEntry &packed = entries[slot_of[i]];
+    packed = ArchiveEntry{};
+    packed.path = append_span(out, files[i].first);
+    packed.last_modified = entry.last_modified;
+    packed.mime = static_cast<uint32_t>(entry.mime);
+    for (size_t v = 0; v < kVariantCount; ++v) {
+      const StaticCacheVariant &variant = entry.variants[v];
+      packed.variants[v].headers = append_span(out, variant.headers);
+      packed.variants[v].etag = append_span(out, variant.etag);
+      packed.variants[v].validators_offset = variant.validators_offset;
+    }
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    const StaticCacheEntry &entry = *files[i].second;
+    ArchiveEntry &packed = entries[slot_of[i]];
+    for (size_t v = 0; v < kVariantCount; ++v) {
+      const std::string &body = entry.variants[v].body;
+      if (!body.empty()) {
+        out.resize(align_up(out.size(), STATIC_ARCHIVE_ALIGN));
+      }
+      packed.variants[v].body = append_span(out, body);
+    }
+  }
+  header.size = out.size();
+  std::memcpy(out.data(), &header, sizeof(header));
+  std::memcpy(out.data() + header.entries_offset, entries.data(),
+              count * sizeof(ArchiveEntry));
+
+  std::string temp_path = archive_path + ".tmp";
+  if (!write_file(temp_path, out) ||
+      std::rename(temp_path.c_str(), archive_path.c_str()) != 0) {
+    std::cerr << "写静态归档失败: " << archive_path << ": "
+              << strerror(errno) << std::endl;
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool StaticArchive::open(const std::string &archive_path) {
+  int fd = ::open(archive_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(ArchiveHeader)) {
+    close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  void *base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+  const char *data = static_cast<const char *>(base);
+  auto mapping = std::make_shared<Mapping>(data, size);
+
+  ArchiveHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  auto in_range = [size](uint64_t offset, uint64_t length) {
+    return offset <= size && length <= size - offset;
+  };
+  if (std::memcmp(header.magic, kArchiveMagic, sizeof(kArchiveMagic)) != 0 ||
+      header.size != size || header.buckets == 0 ||
+      !in_range(header.seeds_offset,
+                static_cast<uint64_t>(header.buckets) * sizeof(uint32_t)) ||
+      !in_range(header.entries_offset,
+                static_cast<uint64_t>(header.count) * sizeof(ArchiveEntry))) {
+    std::cerr << "静态归档无效: " << archive_path << std::endl;
+    return false;
+  }
+
+  std::vector<uint32_t> &seeds = mapping->seeds;
+  seeds.resize(header.buckets);
+  std::memcpy(seeds.data(), data + header.seeds_offset,
+              seeds.size() * sizeof(uint32_t));
+  std::vector<StaticArchiveFile> &files = mapping->files;
+  files.resize(header.count);
+  auto view = [&](const ArchiveSpan &span, std::string_view &out) {
+    if (!in_range(span.offset, span.size)) {
+      return false;
+    }
+    out = std::string_view(data + span.offset, span.size);
+    return true;
+  };
+  for (uint32_t i = 0; i < header.count; ++i) {
+    ArchiveEntry entry;
+    std::memcpy(&entry, data + header.entries_offset + i * sizeof(entry),
+                sizeof(entry));
+    StaticArchiveFile &file = files[i];
+    bool ok = view(entry.path, file.path) &&
+              entry.mime <= static_cast<uint32_t>(HttpMime::OCTET_STREAM);
+    for (size_t v = 0; ok && v < kVariantCount; ++v) {
+      StaticArchiveVariant &variant = file.variants[v];
+      ok = view(entry.variants[v].headers, variant.headers) &&
+           view(entry.variants[v].body, variant.body) &&
+           view(entry.variants[v].etag, variant.etag) &&
+           entry.variants[v].validators_offset <= variant.headers.size();
+      variant.validators_offset = entry.variants[v].validators_offset;
+    }
+    if (!ok) {
+      std::cerr << "静态归档条目越界: " << archive_path << std::endl;
+      return false;
+    }
+    file.mime = static_cast<HttpMime>(entry.mime);
+    file.last_modified = entry.last_modified;
+  }
+
+  // 每个路径都须查回自己的槽位，否则索引和哈希函数不一致
+  for (const StaticArchiveFile &file : files) {
+    if (mapping->lookup(file.path) != &file) {
+      std::cerr << "静态归档索引不一致: " << archive_path << std::endl;
+      return false;
+    }
+  }
+  mapping_ = std::move(mapping);
+  return true;
+}
+
+StaticArchive::Mapping::~Mapping() {
+  munmap(const_cast<char *>(data), size);
+}
+
+const StaticArchiveFile *
+StaticArchive::Mapping::lookup(std::string_view path) const {
+  if (files.empty()) {
+    return nullptr;
+  }
+  uint32_t seed = seeds[hash(path, 0) % seeds.size()];
+  const StaticArchiveFile &file = files[hash(path, seed) % files.size()];
+  return file.path == path ? &file : nullptr;
+}
+
+StaticArchive::FilePtr StaticArchive::find(std::string_view path) const {
+  const StaticArchiveFile *file = mapping_ ? mapping_->lookup(path) : nullptr;
+  if (!file) {
+    return nullptr;
+  }
+  // 与条目所在的映射共享所有权：它在最后一个响应写完前不会释放
+  return FilePtr(mapping_, file);
+}
@@ -0,0 +1,556 @@
+#include "static_file_cache.h"
+#include "http_response.h"
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace {
+
+// 节点、索引和键的大致开销，计入预算避免大量小文件超出内存
+constexpr size_t kEntryOverhead = 256;
+
+int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+int64_t mtime_ns(const struct stat &st) {
+  return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+         st.st_mtim.tv_nsec;
+}
+
+// 64位内容哈希：每次处理8字节，只在加载文件时计算一次
+uint64_t content_hash(std::string_view data) {
+  constexpr uint64_t kMultiplier = 0x9e3779b97f4a7c15ULL;
+  uint64_t hash = data.size() * kMultiplier;
+  size_t i = 0;
+  for (; i + 8 <= data.size(); i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data.data() + i, 8);
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 29;
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, data.data() + i, data.size() - i);
+  hash = (hash ^ tail) * kMultiplier;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+bool read_whole_file(const std::string &path, std::string &out,
+                     struct stat &st, size_t max_size) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+      static_cast<size_t>(st.st_size) > max_size) {
+    close(fd);
+    return false;
+  }
+  out.resize(st.st_size);
+  size_t total_read = 0;
+  while (total_read < out.size()) {
+    ssize_t n = read(fd, out.data() + total_read, out.size() - total_read);
+    if (n <= 0) {
+      break;
+    }
+    total_read += n;
+  }
+  close(fd);
+  // 读的过程中文件被截断，这次不缓存
+  return total_read == out.size();
+}
+
+// 可以压缩的文本类型
+bool is_compressible(HttpMime mime) {
+  return mime == HttpMime::HTML || mime == HttpMime::PLAIN ||
+         mime == HttpMime::CSS || mime == HttpMime::JAVASCRIPT;
+}
+
+constexpr std::string_view kEncodingFileSuffix[] = {"", ".gz", ".br"};
+constexpr std::string_view kEncodingEtagSuffix[] = {"", "-gz", "-br"};
+constexpr std::string_view kEncodingLine[] = {
+    "", "Content-Encoding: gzip\r\n", "Content-Encoding: br\r\n"};
+
+// 没有对应的库时返回false，只提供原始内容
+bool gzip_compress(std::string_view in, std::string &out, int level) {
+#ifdef HAVE_ZLIB
+  z_stream stream = {};
+  // windowBits加16输出gzip格式
+  if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 9,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  out.resize(deflateBound(&stream, in.size()));
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+  stream.avail_in = in.size();
+  stream.next_out = reinterpret_cast<Bytef *>(out.data());
+  stream.avail_out = out.size();
+  int result = deflate(&stream, Z_FINISH);
+  out.resize(stream.total_out);
+  deflateEnd(&stream);
+  return result == Z_STREAM_END;
+#else
+  (void)in;
+  (void)out;
+  (void)level;
+  return false;
+#endif
+}
+
+bool brotli_compress(std::string_view in, std::string &out, int quality) {
+#ifdef HAVE_BROTLI
+  size_t size = BrotliEncoderMaxCompressedSize(in.size());
+  if (size == 0) {
+    return false;
+  }
+  out.resize(size);
+  if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW,
+                             BROTLI_MODE_TEXT, in.size(),
+                             reinterpret_cast<const uint8_t *>(in.data()),
+                             &size, reinterpret_cast<uint8_t *>(out.data()))) {
+    return false;
+  }
+  out.resize(size);
+  return true;
+#else
+  (void)in;
+  (void)out;
+  (void)quality;
+  return false;
+#endif
+}
+
+} // namespace
+
+bool http_normalize_path(std::string_view url, std::pmr::string &out) {
+  size_t query = url.find_first_of("?#");
+  if (query != std::string_view::npos) {
+    url = url.substr(0, query);
+  }
+  if (url.empty() || url.front() != '/') {
+    return false;
+  }
+
+  out.clear();
+  out.reserve(url.size());
+  size_t i = 0;
+  while (i < url.size()) {
+    // 跳过连续的/，取出下一段
+    while (i < url.size() && url[i] == '/') {
+      ++i;
+    }
+    size_t segment_start = out.size();
+    out.push_back('/');
+    while (i < url.size() && url[i] != '/') {
+      char c = url[i++];
+      if (c == '%') {
+        int high = i + 1 < url.size() ? hex_value(url[i]) : -1;
+        int low = i + 1 < url.size() ? hex_value(url[i + 1]) : -1;
+        if (high < 0 || low < 0) {
+          return false;
+        }
+        c = static_cast<char>(high * 16 + low);
+        if (c == '\0' || c == '/') {
+          return false;
+        }
+        i += 2;
+      }
+      out.push_back(c);
+    }
+
+    std::string_view segment(out.data() + segment_start + 1,
+                             out.size() - segment_start - 1);
+    if (segment == ".") {
+      out.resize(segment_start);
+    } else if (segment == "..") {
+      if (segment_start == 0) {
+        return false;
+      }
+      out.resize(out.rfind('/', segment_start - 1));
+    } else if (segment.empty() && i < url.size()) {
+      out.resize(segment_start);
+    }
+  }
+  if (out.empty()) {
+    out.push_back('/');
+  }
+  return true;
+}
+
+StaticFileCache::StaticFileCache(std::string root, size_t budget)
+    : root_(std::move(root)),
+      shard_budget_(std::max<size_t>(budget / STATIC_CACHE_SHARDS, 1)) {}
+
+StaticFileCache &StaticFileCache::instance() {
+  static StaticFileCache cache(HTTP_STATIC_ROOT, STATIC_CACHE_BUDGET);
+  return cache;
+}
+
+StaticFileCache::Shard &StaticFileCache::shard_for(std::string_view path) {
+  return shards_[std::hash<std::string_view>()(path) % STATIC_CACHE_SHARDS];
+}
+
+bool StaticFileCache::is_fresh(const StaticCacheEntry &entry,
+                               std::string_view path, time_t now) const {
+  time_t checked = entry.checked_at.load(std::memory_order_relaxed);
+  if (now - checked < STATIC_CACHE_REVALIDATE_SECONDS) {
+    return true;
+  }
+  // 其他线程正在确认，先继续使用旧内容
+  if (!entry.checked_at.compare_exchange_strong(checked, now,
+                                                std::memory_order_relaxed)) {
+    return true;
+  }
+  std::string full_path = root_;
+  full_path.append(path);
+  struct stat st;
+  return stat(full_path.c_str(), &st) == 0 &&
+         static_cast<size_t>(st.st_size) == entry.identity().body.size() &&
+         mtime_ns(st) == entry.mtime_ns;
+}
+
+StaticFileCache::EntryPtr
+StaticFileCache::load(const std::string &path, size_t max_size,
+                      Compression compression) const {
+  std::string body;
+  struct stat st;
+  if (!read_whole_file(root_ + path, body, st, max_size)) {
+    return nullptr;
+  }
+  return build_entry(path, std::move(body), mtime_ns(st), compression);
+}
+
+StaticFileCache::EntryPtr
+StaticFileCache::build_entry(const std::string &path, std::string body,
+                             int64_t mtime, Compression compression) const {
+  std::string full_path = root_ + path;
+  auto entry = std::make_shared<StaticCacheEntry>();
+  entry->variants[0].body = std::move(body);
+  entry->mime = http_mime_from_path(path);
+  entry->last_modified = static_cast<time_t>(mtime / 1000000000);
+  entry->mtime_ns = mtime;
+  // 超过缓存上限的文件（只在打包时读入）不生成压缩版本
+  if (is_compressible(entry->mime) &&
+      entry->identity().body.size() >= STATIC_CACHE_MIN_COMPRESS &&
+      entry->identity().body.size() <= STATIC_CACHE_MAX_ENTRY) {
+    load_variants(full_path, entry->mtime_ns, compression, *entry);
+  }
+
+  // 强ETag："<16位十六进制内容哈希>"，压缩版本加编码后缀
+  char hex[16];
+  uint64_t hash = content_hash(entry->identity().body);
+  for (int i = 15; i >= 0; --i) {
+    hex[i] = "0123456789abcdef"[hash & 0xf];
+    hash >>= 4;
+  }
+  bool vary = entry->has_variant(ContentEncoding::GZIP) ||
+              entry->has_variant(ContentEncoding::BROTLI);
+  for (size_t i = 0; i < static_cast<size_t>(ContentEncoding::COUNT); ++i) {
+    if (!entry->has_variant(static_cast<ContentEncoding>(i))) {
+      continue;
+    }
+    StaticCacheVariant &variant = entry->variants[i];
+    variant.etag.push_back('"');
+    variant.etag.append(hex, sizeof(hex));
+    variant.etag.append(kEncodingEtagSuffix[i]);
+    variant.etag.push_back('"');
+
+    char digits[24];
+    auto result =
+        std::to_chars(digits, digits + sizeof(digits), variant.body.size());
+    variant.headers.append(http_content_type_line(entry->mime));
+    variant.headers.append(kContentLengthPrefix);
+    variant.headers.append(digits, result.ptr - digits);
+    variant.headers.append("\r\n");
+    variant.headers.append(kEncodingLine[i]);
+    if (i == 0) {
+      // 范围请求只针对原始内容
+      variant.headers.append("Accept-Ranges: bytes\r\n");
+    }
+    variant.validators_offset = variant.headers.size();
+    if (vary) {
+      variant.headers.append("Vary: Accept-Encoding\r\n");
+    }
+    char validators[kValidatorsMaxSize];
+    variant.headers.append(validators,
+                           http_format_validators(validators, variant.etag,
+                                                  entry->last_modified));
+  }
+  entry->checked_at.store(std::time(nullptr), std::memory_order_relaxed);
+  return entry;
+}
+
+void StaticFileCache::load_variants(const std::string &full_path,
+                                    int64_t mtime, Compression compression,
+                                    StaticCacheEntry &entry) const {
+  bool best = compression == Compression::BEST;
+  std::string_view original = entry.identity().body;
+  for (size_t i = 1; i < static_cast<size_t>(ContentEncoding::COUNT); ++i) {
+    std::string &body = entry.variants[i].body;
+    // 同目录下不比原文件旧的预压缩文件（.gz/.br）直接使用
+    struct stat st;
+    if (read_whole_file(full_path + std::string(kEncodingFileSuffix[i]), body,
+                        st, STATIC_CACHE_MAX_ENTRY) &&
+        mtime_ns(st) >= mtime) {
+      continue;
+    }
+    body.clear();
+    bool compressed = static_cast<ContentEncoding>(i) == ContentEncoding::GZIP
+                          ? gzip_compress(original, body,
+                                          best ? STATIC_CACHE_GZIP_LEVEL
+                                               : STATIC_CACHE_FAST_GZIP_LEVEL)
+                          : brotli_compress(
+                                original, body,
+                                best ? STATIC_CACHE_BROTLI_QUALITY
+                                     : STATIC_CACHE_FAST_BROTLI_QUALITY);
+    // 压缩收益太小时不保留，省掉客户端解压
+    if (!compressed || body.size() + original.size() / 10 >= original.size()) {
+      body.clear();
+    }
+  }
+}
+
+bool StaticFileCache::resident(std::string_view path) {
+  Shard &shard = shard_for(path);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(path);
+  if (it == shard.index.end()) {
+    return false;
+  }
+  const EntryPtr &entry = it->second->entry;
+  if (!entry) {
+    return false;
+  }
+  time_t checked = entry->checked_at.load(std::memory_order_relaxed);
+  return std::time(nullptr) - checked < STATIC_CACHE_REVALIDATE_SECONDS;
+}
+
+size_t StaticFileCache::preload() {
+  // 监听开始前调用，没有并发的请求，不需要合并未命中
+  size_t loaded = 0;
+  for (const std::string &path : list_files()) {
+    EntryPtr entry = load(path, STATIC_CACHE_MAX_ENTRY, Compression::BEST);
+    if (!entry) {
+      continue;
+    }
+    Shard &shard = shard_for(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    insert_locked(shard, path, std::move(entry));
+    loads_.fetch_add(1, std::memory_order_relaxed);
+    ++loaded;
+  }
+  return loaded;
+}
+
+bool StaticFileCache::insert(const std::string &path, std::string body,
+                             int64_t mtime) {
+  if (body.size() > STATIC_CACHE_MAX_ENTRY) {
+    return false;
+  }
+  EntryPtr entry =
+      build_entry(path, std::move(body), mtime, Compression::BEST);
+  Shard &shard = shard_for(path);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  insert_locked(shard, path, std::move(entry));
+  loads_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+std::vector<std::string> StaticFileCache::list_files() const {
+  std::vector<std::string> paths;
+  std::error_code error;
+  for (auto it = std::filesystem::recursive_directory_iterator(
+           root_, std::filesystem::directory_options::skip_permission_denied,
+           error);
+       !error && it != std::filesystem::recursive_directory_iterator();
+       it.increment(error)) {
+    if (!it->is_regular_file(error)) {
+      continue;
+    }
+    std::string extension = it->path().extension().string();
+    if (extension == ".gz" || extension == ".br") {
+      continue;
+    }
+    std::string path =
+        "/" + std::filesystem::relative(it->path(), root_, error).string();
+    if (!error) {
+      paths.push_back(std::move(path));
+    }
+  }
+  return paths;
+}
+
+void StaticFileCache::erase_locked(Shard &shard, std::string_view path) {
+  auto it = shard.index.find(path);
+  if (it == shard.index.end()) {
+    return;
+  }
+  auto node = it->second;
+  shard.bytes -= node->charge;
+  shard.index.erase(it);
+  shard.lru.erase(node);
+}
+
+void StaticFileCache::insert_locked(Shard &shard, const std::string &path,
+                                    EntryPtr entry) {
+  erase_locked(shard, path);
+  size_t charge = path.size() + kEntryOverhead;
+  time_t recorded = 0;
+  if (entry) {
+    for (const StaticCacheVariant &variant : entry->variants) {
+      charge += variant.headers.size() + variant.body.size();
+    }
+  } else {
+    recorded = std::time(nullptr);
+  }
+  if (charge > shard_budget_) {
+    return;
+  }
+  shard.lru.push_front(Node{path, std::move(entry), charge, recorded});
+  shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+  shard.bytes += charge;
+  // 从表尾淘汰最久未使用的条目，正在发送的条目由连接持有引用，不受影响
+  while (shard.bytes > shard_budget_) {
+    Node &victim = shard.lru.back();
+    shard.bytes -= victim.charge;
+    shard.index.erase(victim.key);
+    shard.lru.pop_back();
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+StaticFileCache::EntryPtr StaticFileCache::get(std::string_view path) {
+  Shard &shard = shard_for(path);
+  time_t now = std::time(nullptr);
+  EntryPtr cached;
+  bool known_missing = false;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(path);
+    if (it != shard.index.end()) {
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      cached = it->second->entry;
+      known_missing = !cached && now - it->second->recorded <
+                                     STATIC_CACHE_REVALIDATE_SECONDS;
+    }
+  }
+  if (cached && is_fresh(*cached, path, now)) {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return cached;
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  if (known_missing) {
+    // 刚确认过不存在或太大，不再重复open/fstat
+    return nullptr;
+  }
+
+  // 未命中：第一个线程负责读文件，其余线程等待同一个结果
+  std::string key(path);
+  std::promise<EntryPtr> promise;
+  std::shared_future<EntryPtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto loading = shard.loading.find(key);
+    if (loading != shard.loading.end()) {
+      pending = loading->second;
+    } else {
+      auto it = shard.index.find(path);
+      if (it != shard.index.end() && it->second->entry != cached) {
+        // 检查期间已有其他线程重新加载
+        return it->second->entry;
+      }
+      shard.loading.emplace(key, promise.get_future().share());
+    }
+  }
+  if (pending.valid()) {
+    coalesced_.fetch_add(1, std::memory_order_relaxed);
+    return pending.get();
+  }
+
+  loads_.fetch_add(1, std::memory_order_relaxed);
+  EntryPtr entry = load(key, STATIC_CACHE_MAX_ENTRY, Compression::FAST);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.loading.erase(key);
+    insert_locked(shard, key, entry);
+  }
+  promise.set_value(entry);
+  return entry;
+}
+
+StaticFileCache::EntryPtr StaticFileCache::find(std::string_view path) {
+  Shard &shard = shard_for(path);
+  EntryPtr cached;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(path);
+    if (it != shard.index.end()) {
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      cached = it->second->entry;
+    }
+  }
+  if (cached && is_fresh(*cached, path, std::time(nullptr))) {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return cached;
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+StaticFileCache::EntryPtr StaticFileCache::fill(const std::string &path,
+                                                std::string body,
+                                                int64_t mtime) {
+  if (body.size() > STATIC_CACHE_MAX_ENTRY) {
+    return nullptr;
+  }
+  EntryPtr entry =
+      build_entry(path, std::move(body), mtime, Compression::FAST);
+  Shard &shard = shard_for(path);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  insert_locked(shard, path, entry);
+  loads_.fetch_add(1, std::memory_order_relaxed);
+  return entry;
+}
+
+StaticFileCache::Stats StaticFileCache::stats() {
+  Stats stats{};
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.loads = loads_.load(std::memory_order_relaxed);
+  stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+  stats.evictions = evictions_.load(std::memory_order_relaxed);
+  for (Shard &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    stats.bytes += shard.bytes;
+    stats.entries += shard.lru.size();
+  }
+  return stats;
+}
+
+void StaticFileCache::clear() {
+  for (Shard &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.index.clear();
+    shard.lru.clear();
+    shard.bytes = 0;
+  }
+}
@@ -0,0 +1,225 @@
+#include "static_path_index.h"
+#include "static_file_cache.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <unistd.h>
+
+StaticPathIndex::StaticPathIndex(std::string root)
+    : root_(std::move(root)), enabled_(false), inotify_fd_(-1),
+      incomplete_(false) {}
+
+StaticPathIndex::~StaticPathIndex() {
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+  }
+}
+
+StaticPathIndex &StaticPathIndex::instance() {
+  static StaticPathIndex index(HTTP_STATIC_ROOT);
+  return index;
+}
+
+uint64_t StaticPathIndex::hash(std::string_view path) {
+  return std::hash<std::string_view>()(path);
+}
+
+void StaticPathIndex::add_locked(const std::string &path) {
+  if (paths_.insert(path).second) {
+    ++hashes_[hash(path)];
+  }
+}
+
+void StaticPathIndex::remove_locked(const std::string &path) {
+  if (paths_.erase(path) == 0) {
+    return;
+  }
+  auto it = hashes_.find(hash(path));
+  if (it != hashes_.end() && --it->second == 0) {
+    hashes_.erase(it);
+  }
+}
+
+void StaticPathIndex::remove_dir_locked(const std::string &dir) {
+  // 有序集合中dir/下的路径是连续的一段：[dir + "/", dir + "0")
+  auto first = paths_.lower_bound(dir + "/");
+  auto last = paths_.lower_bound(dir + "0");
+  for (auto it = first; it != last; ++it) {
+    auto counted = hashes_.find(hash(*it));
+    if (counted != hashes_.end() && --counted->second == 0) {
+      hashes_.erase(counted);
+    }
+  }
+  paths_.erase(first, last);
+
+  for (auto it = dirs_.begin(); it != dirs_.end();) {
+    const std::string &watched = it->second;
+    if (watched.compare(0, dir.size(), dir) == 0 &&
+        (watched.size() == dir.size() || watched[dir.size()] == '/')) {
+      // 被删除的目录内核已移除监视，这里失败无妨；被移走的目录须主动移除
+      inotify_rm_watch(inotify_fd_, it->first);
+      it = dirs_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void StaticPathIndex::scan_locked(const std::string &dir) {
+  std::string full_path = root_ + dir;
+  int wd = inotify_add_watch(inotify_fd_, full_path.c_str(),
+                             STATIC_INDEX_WATCH_MASK);
+  if (wd < 0) {
+    if (errno != ENOENT && errno != ENOTDIR) {
+      // 监视数达到上限等：之后的变化无从得知
+      std::cerr << "监视目录失败: " << full_path << ": " << strerror(errno)
+                << std::endl;
+      incomplete_ = true;
+    }
+    return;
+  }
+  dirs_[wd] = dir;
+
+  std::error_code error;
+  for (auto it = std::filesystem::directory_iterator(full_path, error);
+       !error && it != std::filesystem::directory_iterator();
+       it.increment(error)) {
+    std::string path = dir + "/" + it->path().filename().string();
+    if (it->is_directory(error)) {
+      if (it->is_symlink(error)) {
+        incomplete_ = true;
+        continue;
+      }
+      scan_locked(path);
+    } else {
+      // 普通文件以外的目录项也记入，多出的路径照常交给文件系统判断
+      add_locked(path);
+    }
+  }
+}
+
+void StaticPathIndex::rebuild_locked() {
+  for (const auto &watch : dirs_) {
+    inotify_rm_watch(inotify_fd_, watch.first);
+  }
+  dirs_.clear();
+  paths_.clear();
+  hashes_.clear();
+  scan_locked("");
+}
+
+size_t StaticPathIndex::build() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  if (inotify_fd_ < 0) {
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+      std::cerr << "inotify初始化失败，不启用静态路径索引: "
+                << strerror(errno) << std::endl;
+      return 0;
+    }
+  }
+  rebuild_locked();
+  enabled_ = !dirs_.empty() && !incomplete_;
+  if (!enabled_) {
+    std::cerr << "静态根目录无法完整监视，不启用静态路径索引" << std::endl;
+  }
+  return paths_.size();
+}
+
+bool StaticPathIndex::may_exist(std::string_view path) const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return !enabled_ || hashes_.count(hash(path)) > 0;
+}
+
+size_t StaticPathIndex::handle_watch_events(const char *events, int result) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  if (!enabled_ || result == -EAGAIN || result == -EINTR) {
+    return 0;
+  }
+  if (result < 0) {
+    // 读不到事件就无法保证索引最新
+    std::cerr << "读取inotify事件失败，停用静态路径索引: "
+              << strerror(-result) << std::endl;
+    enabled_ = false;
+    return 0;
+  }
+  size_t changed = 0;
+  size_t offset = 0;
+  while (offset + sizeof(struct inotify_event) <=
+         static_cast<size_t>(result)) {
+    const auto *event =
+        reinterpret_cast<const struct inotify_event *>(events + offset);
+    offset += sizeof(struct inotify_event) + event->len;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+      // 事件丢失，重新遍历
+      rebuild_locked();
+      ++changed;
+      continue;
+    }
+    auto it = dirs_.find(event->wd);
+    if (it == dirs_.end()) {
+      continue;
+    }
+    if (event->mask & IN_IGNORED) {
+      dirs_.erase(it);
+      continue;
+    }
+    if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+      if (it->second.empty()) {
+        // 根目录没了，之后在原路径新建的目录不在监视中
+        std::cerr << "静态根目录被删除或移走，停用静态路径索引" << std::endl;
+        enabled_ = false;
+        return changed;
+      }
+      // 子目录自身的变化由父目录的事件处理
+      continue;
+    }
+    if (event->len == 0) {
+      continue;
+    }
+
+    std::string path = it->second + "/" + event->name;
+    bool added = event->mask & (IN_CREATE | IN_MOVED_TO);
+    if (event->mask & IN_ISDIR) {
+      if (added) {
+        scan_locked(path);
+      } else {
+        remove_dir_locked(path);
+      }
+    } else if (added) {
+      std::error_code error;
+      if (std::filesystem::is_directory(root_ + path, error)) {
+        // 新建了指向目录的符号链接
+        incomplete_ = true;
+      }
+      add_locked(path);
+    } else {
+      remove_locked(path);
+    }
+    ++changed;
+  }
+  if (incomplete_ || dirs_.empty()) {
+    std::cerr << "静态根目录无法完整监视，停用静态路径索引" << std::endl;
+    enabled_ = false;
+  }
+  return changed;
+}
+
+void StaticPathIndex::disable() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  enabled_ = false;
+}
+
+bool StaticPathIndex::enabled() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return enabled_;
+}
+
+size_t StaticPathIndex::size() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return paths_.size();
+}
@@ -0,0 +1,235 @@
+#include "uring_file_table.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+UringFileTable::UringFileTable(struct io_uring *ring)
+    : ring_(ring), registered_(false), inotify_fd_(-1),
+      slots_(URING_FILE_TABLE_SIZE), clock_(0) {}
+
+UringFileTable::~UringFileTable() {
+  // 固定文件表随环一起注销，这里只关闭自己持有的描述符
+  for (Slot &slot : slots_) {
+    if (slot.fd >= 0) {
+      close(slot.fd);
+    }
+  }
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+  }
+}
+
+bool UringFileTable::init() {
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0) {
+    // 没有inotify就无法得知文件变化，不缓存描述符
+    std::cerr << "inotify初始化失败，不缓存文件描述符: " << strerror(errno)
+              << std::endl;
+    return false;
+  }
+
+  int ret = io_uring_register_files_sparse(ring_, URING_FILE_TABLE_SIZE);
+  if (ret < 0) {
+    // 旧内核不支持稀疏注册，用全部为-1的表代替
+    std::vector<int> empty(URING_FILE_TABLE_SIZE, -1);
+    ret = io_uring_register_files(ring_, empty.data(), empty.size());
+  }
+  registered_ = ret == 0;
+  if (!registered_) {
+    std::cerr << "固定文件表注册失败，缓存的描述符按普通描述符使用: "
+              << strerror(-ret) << std::endl;
+  }
+  return true;
+}
+
+void UringFileTable::invalidate(int index) {
+  Slot &slot = slots_[index];
+  if (slot.stale || slot.fd < 0) {
+    return;
+  }
+  index_.erase(slot.path);
+  if (slot.wd >= 0) {
+    watches_.erase(slot.wd);
+    inotify_rm_watch(inotify_fd_, slot.wd);
+    slot.wd = -1;
+  }
+  slot.stale = true;
+  if (slot.refs == 0) {
+    close_slot(index);
+  }
+}
+
+void UringFileTable::close_slot(int index) {
+  Slot &slot = slots_[index];
+  if (registered_) {
+    int empty = -1;
+    io_uring_register_files_update(ring_, index, &empty, 1);
+  }
+  close(slot.fd);
+  slot.fd = -1;
+  slot.path.clear();
+  slot.stale = false;
+  slot.refs = 0;
+}
+
+bool UringFileTable::lookup(UringConnectionInfo *conn) {
+  UringFileOp &op = conn->file_op;
+  if (inotify_fd_ < 0 || op.borrowed()) {
+    return false;
+  }
+  auto it = index_.find(op.path);
+  if (it == index_.end()) {
+    return false;
+  }
+  Slot &slot = slots_[it->second];
+  ++slot.refs;
+  slot.last_used = ++clock_;
+
+  op.fd = slot.fd;
+  op.stat_result = 0;
+  op.stx = slot.stx;
+  op.slot = it->second;
+  op.fixed = registered_;
+  op.outstanding = 0;
+  op.state = UringFileOpState::READY;
+  return true;
+}
+
+bool UringFileTable::adopt(UringConnectionInfo *conn) {
+  UringFileOp &op = conn->file_op;
+  if (inotify_fd_ < 0 || op.borrowed() || op.fd < 0 || op.stat_result != 0 ||
+      !S_ISREG(op.stx.stx_mode) || index_.count(op.path) > 0) {
+    return false;
+  }
+  // STATX按路径执行，确认打开的描述符就是它看到的那个文件
+  struct stat st;
+  if (fstat(op.fd, &st) != 0 || st.st_ino != op.stx.stx_ino ||
+      st.st_mtim.tv_sec != op.stx.stx_mtime.tv_sec ||
+      st.st_mtim.tv_nsec != static_cast<long>(op.stx.stx_mtime.tv_nsec)) {
+    return false;
+  }
+
+  // 优先用空槽，没有时淘汰最久未用且没有连接在用的项
+  int index = -1;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    const Slot &slot = slots_[i];
+    if (slot.fd < 0) {
+      index = static_cast<int>(i);
+      break;
+    }
+    if (!slot.stale && slot.refs == 0 &&
+        (index < 0 || slot.last_used < slots_[index].last_used)) {
+      index = static_cast<int>(i);
+    }
+  }
+  if (index < 0) {
+    return false;
+  }
+  if (slots_[index].fd >= 0) {
+    invalidate(index);
+  }
+
+  int wd = inotify_add_watch(inotify_fd_, op.path.c_str(),
+                             URING_FILE_WATCH_MASK);
+  if (wd < 0 || watches_.count(wd) > 0) {
+    // 同一个inode经另一条路径已在缓存中，监视描述符相同，不重复缓存
+    return false;
+  }
+  if (registered_ &&
+      io_uring_register_files_update(ring_, index, &op.fd, 1) < 0) {
+    inotify_rm_watch(inotify_fd_, wd);
+    return false;
+  }
+
+  Slot &slot = slots_[index];
+  slot.path = op.path;
+  slot.fd = op.fd;
+  slot.wd = wd;
+  slot.stx = op.stx;
+  slot.refs = 1;
+  slot.last_used = ++clock_;
+  slot.stale = false;
+  index_[slot.path] = index;
+  watches_[wd] = index;
+
+  op.slot = index;
+  op.fixed = registered_;
+  return true;
+}
+
+void UringFileTable::release(UringConnectionInfo *conn) {
+  UringFileOp &op = conn->file_op;
+  if (!op.borrowed()) {
+    return;
+  }
+  Slot &slot = slots_[op.slot];
+  op.slot = -1;
+  op.fixed = false;
+  if (slot.refs > 0) {
+    --slot.refs;
+  }
+  if (slot.stale && slot.refs == 0) {
+    close_slot(&slot - slots_.data());
+  }
+}
+
+bool UringFileTable::prep_watch_read(struct io_uring_sqe *sqe) {
+  if (inotify_fd_ < 0) {
+    return false;
+  }
+  io_uring_prep_read(sqe, inotify_fd_, events_, sizeof(events_), 0);
+  io_uring_sqe_set_data(sqe, this);
+  return true;
+}
+
+size_t UringFileTable::handle_watch_events(int result) {
+  size_t invalidated = 0;
+  if (result < 0) {
+    if (result == -EAGAIN || result == -EINTR) {
+      return 0;
+    }
+    // inotify读不了就无法再确认缓存有效，全部失效并停止缓存
+    std::cerr << "读取inotify事件失败: " << strerror(-result) << std::endl;
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      if (slots_[i].fd >= 0 && !slots_[i].stale) {
+        invalidate(static_cast<int>(i));
+        ++invalidated;
+      }
+    }
+    close(inotify_fd_);
+    inotify_fd_ = -1;
+    return invalidated;
+  }
+
+  size_t offset = 0;
+  while (offset + sizeof(struct inotify_event) <= static_cast<size_t>(result)) {
+    const auto *event =
+        reinterpret_cast<const struct inotify_event *>(events_ + offset);
+    offset += sizeof(struct inotify_event) + event->len;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+      // 事件丢失，不知道哪些文件变了
+      for (size_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i].fd >= 0 && !slots_[i].stale) {
+          invalidate(static_cast<int>(i));
+          ++invalidated;
+        }
+      }
+      continue;
+    }
+    auto it = watches_.find(event->wd);
+    if (it == watches_.end()) {
+      continue;
+    }
+    int index = it->second;
+    if (event->mask & IN_IGNORED) {
+      // 监视已被内核移除，不用再rm_watch
+      watches_.erase(it);
+      slots_[index].wd = -1;
+    }
+    invalidate(index);
+    ++invalidated;
+  }
+  return invalidated;
+}
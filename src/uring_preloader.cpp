@@ -0,0 +1,267 @@
+#include "uring_preloader.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+UringPreloader::UringPreloader(StaticFileCache &cache)
+    : cache_(cache), initialized_(false), jobs_(URING_PRELOAD_QUEUE_DEPTH / 2),
+      reserved_(0), stats_() {}
+
+UringPreloader::~UringPreloader() {
+  if (initialized_) {
+    io_uring_queue_exit(&ring_);
+  }
+}
+
+bool UringPreloader::init() {
+  int ret = io_uring_queue_init(URING_PRELOAD_QUEUE_DEPTH, &ring_, 0);
+  if (ret < 0) {
+    std::cerr << "预加载环初始化失败: " << strerror(-ret) << std::endl;
+    return false;
+  }
+  initialized_ = true;
+  return true;
+}
+
+void UringPreloader::start_open(Job &job, const std::string &path) {
+  job.path = path;
+  job.full_path = cache_.root() + path;
+  job.fd = -1;
+  job.stat_result = 0;
+  job.body.clear();
+  job.offset = 0;
+
+  // 链接的请求按提交顺序完成：先OPENAT后STATX，环的深度保证取得到SQE
+  struct io_uring_sqe *open_sqe = io_uring_get_sqe(&ring_);
+  struct io_uring_sqe *stat_sqe = io_uring_get_sqe(&ring_);
+  io_uring_prep_openat(open_sqe, AT_FDCWD, job.full_path.c_str(),
+                       O_RDONLY | O_CLOEXEC, 0);
+  io_uring_sqe_set_data(open_sqe, &job);
+  open_sqe->flags |= IOSQE_IO_LINK;
+  io_uring_prep_statx(stat_sqe, AT_FDCWD, job.full_path.c_str(), 0,
+                      STATX_TYPE | STATX_SIZE | STATX_MTIME, &job.stx);
+  io_uring_sqe_set_data(stat_sqe, &job);
+  job.outstanding = 2;
+  job.state = JobState::OPENING;
+}
+
+void UringPreloader::prep_read(Job &job) {
+  struct io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+  io_uring_prep_read(sqe, job.fd, job.body.data() + job.offset,
+                     job.body.size() - job.offset, job.offset);
+  io_uring_sqe_set_data(sqe, &job);
+  job.state = JobState::READING;
+}
+
+void UringPreloader::prep_close(Job &job) {
+  struct io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+  io_uring_prep_close(sqe, job.fd);
+  io_uring_sqe_set_data(sqe, &job);
+  job.state = JobState::CLOSING;
+}
+
+bool UringPreloader::handle_completion(Job &job, int result) {
+  switch (job.state) {
+  case JobState::OPENING:
+    if (job.outstanding == 2) {
+      job.fd = result;
+    } else {
+      job.stat_result = result;
+    }
+    if (--job.outstanding > 0) {
+      return false;
+    }
+    if (job.fd < 0) {
+      ++stats_.skipped;
+      job.state = JobState::IDLE;
+      return true;
+    }
+    if (job.stat_result < 0 || !S_ISREG(job.stx.stx_mode) ||
+        job.stx.stx_size > STATIC_CACHE_MAX_ENTRY) {
+      ++stats_.skipped;
+      prep_close(job);
+      return false;
+    }
+    // 内容要等全部读完才生成条目，同时持有的总量限制在缓存预算内
+    if (reserved_ + job.stx.stx_size > cache_.budget()) {
+      ++stats_.skipped;
+      prep_close(job);
+      return false;
+    }
+    reserved_ += job.stx.stx_size;
+    job.body.resize(job.stx.stx_size);
+    if (job.body.empty()) {
+      break;
+    }
+    prep_read(job);
+    return false;
+  case JobState::READING:
+    if (result < 0) {
+      ++stats_.skipped;
+      reserved_ -= job.body.size();
+      prep_close(job);
+      return false;
+    }
+    job.offset += result;
+    if (result > 0 && job.offset < job.body.size()) {
+      // 短读：接着读剩下的部分
+      prep_read(job);
+      return false;
+    }
+    // 读到文件尾（文件在STATX之后变短）时保留已读的部分
+    reserved_ -= job.body.size() - job.offset;
+    job.body.resize(job.offset);
+    break;
+  case JobState::CLOSING:
+    job.fd = -1;
+    job.state = JobState::IDLE;
+    return true;
+  case JobState::IDLE:
+    return false;
+  }
+
+  // 读完：内容交给生成条目的阶段
+  stats_.bytes += job.body.size();
+  int64_t mtime =
+      static_cast<int64_t>(job.stx.stx_mtime.tv_sec) * 1000000000 +
+      job.stx.stx_mtime.tv_nsec;
+  loaded_.push_back(Loaded{std::move(job.path), std::move(job.body), mtime});
+  if (loaded_.size() % URING_PRELOAD_PROGRESS == 0) {
+    std::cout << "预加载进度: " << loaded_.size() << "/" << stats_.files
+              << "个文件" << std::endl;
+  }
+  prep_close(job);
+  return false;
+}
+
+// 已提交的请求还引用job中的路径、statx和内容缓冲区，要等它们全部完成，
+// 期间不再提交后续请求；没提交出去的SQE还留在环里，所以最后拆除环
+void UringPreloader::abandon(size_t inflight) {
+  while (inflight > 0) {
+    struct io_uring_cqe *cqe;
+    int ret = io_uring_wait_cqe(&ring_, &cqe);
+    if (ret == -EINTR) {
+      continue;
+    }
+    if (ret < 0) {
+      // 等不到完成事件：拆除环时内核取消剩下的请求
+      std::cerr << "预加载等待完成失败: " << strerror(-ret) << std::endl;
+      break;
+    }
+    Job &job = *static_cast<Job *>(io_uring_cqe_get_data(cqe));
+    int result = cqe->res;
+    io_uring_cqe_seen(&ring_, cqe);
+    --inflight;
+    if (job.state == JobState::OPENING && job.outstanding-- == 2) {
+      job.fd = result;
+    } else if (job.state == JobState::CLOSING) {
+      job.fd = -1;
+    }
+  }
+  for (Job &job : jobs_) {
+    if (job.fd >= 0) {
+      close(job.fd);
+    }
+    job.fd = -1;
+    job.state = JobState::IDLE;
+  }
+  io_uring_queue_exit(&ring_);
+  initialized_ = false;
+}
+
+size_t UringPreloader::build_entries() {
+  size_t threads = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), loaded_.size());
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> inserted{0};
+  auto worker = [this, &next, &inserted] {
+    for (size_t i = next.fetch_add(1); i < loaded_.size();
+         i = next.fetch_add(1)) {
+      Loaded &file = loaded_[i];
+      if (cache_.insert(file.path, std::move(file.body), file.mtime)) {
+        inserted.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < threads; ++i) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (std::thread &thread : workers) {
+    thread.join();
+  }
+  loaded_.clear();
+  reserved_ = 0;
+  return inserted.load();
+}
+
+size_t UringPreloader::run() {
+  if (!initialized_) {
+    return 0;
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::string> paths = cache_.list_files();
+  stats_ = Stats();
+  stats_.files = paths.size();
+  loaded_.clear();
+  loaded_.reserve(paths.size());
+  reserved_ = 0;
+
+  size_t next = 0;
+  size_t active = 0;
+  size_t inflight = 0; // 已提交还没收到完成事件的请求数
+  while (next < paths.size() || active > 0) {
+    // 空闲的槽位全部换成新文件，和上一批的后续请求一起提交
+    for (Job &job : jobs_) {
+      if (next == paths.size()) {
+        break;
+      }
+      if (job.state == JobState::IDLE) {
+        start_open(job, paths[next++]);
+        ++active;
+      }
+    }
+    unsigned queued = io_uring_sq_ready(&ring_);
+    int ret = io_uring_submit_and_wait(&ring_, 1);
+    if (ret < 0 && ret != -EINTR) {
+      std::cerr << "预加载提交失败: " << strerror(-ret) << std::endl;
+      abandon(inflight);
+      break;
+    }
+    inflight += queued - io_uring_sq_ready(&ring_);
+    ++stats_.submits;
+
+    struct io_uring_cqe *cqe;
+    while (io_uring_peek_cqe(&ring_, &cqe) == 0) {
+      Job *job = static_cast<Job *>(io_uring_cqe_get_data(cqe));
+      int result = cqe->res;
+      io_uring_cqe_seen(&ring_, cqe);
+      --inflight;
+      if (handle_completion(*job, result)) {
+        --active;
+      }
+    }
+  }
+  stats_.read_ms = elapsed_ms(start);
+
+  stats_.loaded = build_entries();
+  stats_.total_ms = elapsed_ms(start);
+  return stats_.loaded;
+}
@@ -8,21 +8,31 @@ IoUringServer::IoUringServer(int port)
     : _ring(nullptr), _tcp_listener(std::make_unique<TcpListener>(port)),
       _memory_pool(std::make_unique<LayerMemoryPool>()), _running(false),
       _main_queue(std::make_shared<MainThreadTaskQueue>()),
-      _thread_pool(std::make_unique<ThreadPool>()) {
+      _thread_pool(std::make_unique<ThreadPool>()), _path_index(nullptr) {
 
   if (!initialize_uring()) {
     throw std::runtime_error("初始化io_uring失败");
   }
+  // 工作线程把处理完的请求交回主线程队列时靠它唤醒事件循环
+  if (!_main_queue->enable_wakeup()) {
+    throw std::runtime_error("创建主线程队列的eventfd失败");
+  }
 
-  // 设置线程池的主线程队列
-  _thread_pool->set_main_queue(_main_queue);
+  // 热点文件描述符缓存，初始化失败时不用
+  _file_table = std::make_shared<UringFileTable>(_ring.get());
+  if (!_file_table->init()) {
+    _file_table.reset();
+  }
 
-  _task_dispatcher = std::make_shared<TaskDispatcher>(_thread_pool, _main_queue,
-                                                      _ring, _memory_pool);
+  _task_dispatcher = std::make_shared<TaskDispatcher>(
+      _thread_pool, _main_queue, _ring, _memory_pool, _file_table);
 }
 
 IoUringServer::~IoUringServer() {
   stop();
+  // 先让等待入队的工作线程放弃，工作线程全部退出后才能销毁环
+  _main_queue->stop();
+  _thread_pool->shutdown();
   if (_ring) {
     io_uring_queue_exit(_ring.get());
   }
@@ -78,6 +88,8 @@ bool IoUringServer::set_read_event(UringConnectionInfo *conn) {
   }
 
   conn->state = UringConnectionState::READ;
+  // 保证新数据接在已有数据后面，不绕回到缓冲区开头
+  conn->read_buffer.compact();
   char *buffer = conn->read_buffer.get_write_tail();
   size_t size = conn->read_buffer.get_writable_size();
 
@@ -94,10 +106,10 @@ bool IoUringServer::set_read_event(UringConnectionInfo *conn) {
   return true;
 }
 
-bool IoUringServer::set_write_event(UringConnectionInfo *conn) {
+// 继续把请求体剩余部分读入额外缓冲区
+bool IoUringServer::set_extra_read_event(UringConnectionInfo *conn) {
   struct io_uring_sqe *sqe = io_uring_get_sqe(_ring.get());
   if (!sqe) {
-    // 如果无法获取sqe，先提交当前队列
     io_uring_submit(_ring.get());
     sqe = io_uring_get_sqe(_ring.get());
     if (!sqe) {
@@ -105,12 +117,27 @@ bool IoUringServer::set_write_event(UringConnectionInfo *conn) {
     }
   }
 
-  conn->state = UringConnectionState::WRITE;
-  char *buffer = conn->write_buffer.get_read_head();
-  size_t size = conn->write_buffer.get_readable_size();
+  conn->state = UringConnectionState::READ;
+  char *buffer = conn->extra_buffer + conn->extra_buffer_filled;
+  size_t size = conn->bytes_NO_read - conn->extra_buffer_filled;
 
-  io_uring_prep_write(sqe, conn->fd, buffer, size, 0);
+  io_uring_prep_read(sqe, conn->fd, buffer, size, 0);
   io_uring_sqe_set_data(sqe, conn);
+
+  int submit_ret = io_uring_submit(_ring.get());
+  if (submit_ret < 0) {
+    std::cerr << "提交额外读事件失败: " << submit_ret << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool IoUringServer::set_write_event(UringConnectionInfo *conn) {
+  // 文件流还有数据时会先链接一个READ，队列不足时prep_output自己先提交
+  if (!conn->prep_output(_ring.get())) {
+    return false;
+  }
+  size_t size = conn->pending_write_size();
   std::cout << "设置写事件: fd=" << conn->fd << ", size=" << size << std::endl;
 
   // 立即提交事件
@@ -125,7 +152,11 @@ bool IoUringServer::set_write_event(UringConnectionInfo *conn) {
 bool IoUringServer::set_close_event(UringConnectionInfo *conn) {
   struct io_uring_sqe *sqe = io_uring_get_sqe(_ring.get());
   if (!sqe) {
-    return false;
+    io_uring_submit(_ring.get());
+    sqe = io_uring_get_sqe(_ring.get());
+    if (!sqe) {
+      return false;
+    }
   }
 
   conn->state = UringConnectionState::CLOSE;
@@ -135,10 +166,69 @@ bool IoUringServer::set_close_event(UringConnectionInfo *conn) {
   return true;
 }
 
+// 文件流的最后一段已读完，在环上关闭文件，完成事件不带连接指针
+// 借用描述符缓存的文件不关闭，由缓存在引用释放后处理
+bool IoUringServer::set_file_close_event(UringConnectionInfo *conn) {
+  if (conn->file_stream.borrowed()) {
+    conn->file_stream.close();
+    return true;
+  }
+  struct io_uring_sqe *sqe = io_uring_get_sqe(_ring.get());
+  if (!sqe) {
+    io_uring_submit(_ring.get());
+    sqe = io_uring_get_sqe(_ring.get());
+    if (!sqe) {
+      conn->file_stream.close();
+      return false;
+    }
+  }
+  io_uring_prep_close(sqe, conn->file_stream.fd);
+  io_uring_sqe_set_data(sqe, nullptr);
+  conn->file_stream.fd = -1;
+  return true;
+}
+
+// 最后一个字节写出后半关闭：shutdown(SHUT_WR)发FIN，链接的close随后执行
+// shutdown的完成事件不带连接指针，连接只在close完成时归还一次
+bool IoUringServer::set_shutdown_event(UringConnectionInfo *conn) {
+  if (io_uring_sq_space_left(_ring.get()) < 2) {
+    io_uring_submit(_ring.get());
+  }
+  struct io_uring_sqe *shutdown_sqe = io_uring_get_sqe(_ring.get());
+  if (!shutdown_sqe) {
+    return set_close_event(conn);
+  }
+  struct io_uring_sqe *close_sqe = io_uring_get_sqe(_ring.get());
+  if (!close_sqe) {
+    // 只拿到一个sqe，直接用它关闭
+    conn->state = UringConnectionState::CLOSE;
+    io_uring_prep_close(shutdown_sqe, conn->fd);
+    io_uring_sqe_set_data(shutdown_sqe, conn);
+    return true;
+  }
+
+  conn->state = UringConnectionState::CLOSE;
+  io_uring_prep_shutdown(shutdown_sqe, conn->fd, SHUT_WR);
+  io_uring_sqe_set_data(shutdown_sqe, nullptr);
+  // shutdown失败（对端已断开）也要继续关闭，所以用硬链接
+  shutdown_sqe->flags |= IOSQE_IO_HARDLINK;
+  io_uring_prep_close(close_sqe, conn->fd);
+  io_uring_sqe_set_data(close_sqe, conn);
+
+  int submit_ret = io_uring_submit(_ring.get());
+  if (submit_ret < 0) {
+    std::cerr << "提交关闭事件失败: " << submit_ret << std::endl;
+    return false;
+  }
+  return true;
+}
+
 // 在handle_accept_event中设置主线程队列
 void IoUringServer::handle_accept_event(UringConnectionInfo *conn, int result) {
   if (result >= 0) {
     conn->fd = result;
+    conn->reset();
+    conn->ring_file_io = true;
     std::cout << "新连接接受: fd=" << conn->fd << std::endl;
 
     // 设置主线程队列引用
@@ -167,8 +257,23 @@ void IoUringServer::process_completion_events() {
 
   io_uring_for_each_cqe(_ring.get(), head, cqe) {
     count++;
-    UringConnectionInfo *conn =
-        static_cast<UringConnectionInfo *>(io_uring_cqe_get_data(cqe));
+    void *data = io_uring_cqe_get_data(cqe);
+    if (_file_table && data == _file_table.get()) {
+      handle_watch_event(cqe->res);
+      io_uring_cqe_seen(_ring.get(), cqe);
+      continue;
+    }
+    if (data == _main_queue.get()) {
+      handle_wakeup_event(cqe->res);
+      io_uring_cqe_seen(_ring.get(), cqe);
+      continue;
+    }
+    if (_path_index && data == _path_index) {
+      handle_path_watch_event(cqe->res);
+      io_uring_cqe_seen(_ring.get(), cqe);
+      continue;
+    }
+    UringConnectionInfo *conn = static_cast<UringConnectionInfo *>(data);
 
     if (conn) {
       handle_completion_event(conn, cqe->res);
@@ -193,6 +298,9 @@ void IoUringServer::handle_completion_event(UringConnectionInfo *conn,
   case UringConnectionState::CLOSE:
     handle_close_event(conn);
     break;
+  case UringConnectionState::FILE_OPEN:
+    handle_file_open_event(conn, result);
+    break;
   default:
     std::cerr << "未知连接状态: " << static_cast<int>(conn->state) << std::endl;
     _memory_pool->release_connection(conn);
@@ -202,21 +310,136 @@ void IoUringServer::handle_completion_event(UringConnectionInfo *conn,
 
 void IoUringServer::handle_close_event(UringConnectionInfo *conn) {
   std::cout << "连接关闭完成: fd=" << conn->fd << std::endl;
+  if (_file_table) {
+    _file_table->release(conn);
+  }
   _memory_pool->release_connection(conn);
 }
 
+// 提交读inotify事件，完成事件的user_data为文件描述符缓存
+bool IoUringServer::set_watch_read_event() {
+  struct io_uring_sqe *sqe = io_uring_get_sqe(_ring.get());
+  if (!sqe) {
+    io_uring_submit(_ring.get());
+    sqe = io_uring_get_sqe(_ring.get());
+  }
+  if (!sqe || !_file_table->prep_watch_read(sqe)) {
+    return false;
+  }
+  return true;
+}
+
+// 提交读静态路径索引的inotify事件，完成事件的user_data为索引
+bool IoUringServer::set_path_watch_read_event() {
+  struct io_uring_sqe *sqe = io_uring_get_sqe(_ring.get());
+  if (!sqe) {
+    io_uring_submit(_ring.get());
+    sqe = io_uring_get_sqe(_ring.get());
+    if (!sqe) {
+      return false;
+    }
+  }
+  io_uring_prep_read(sqe, _path_index->inotify_fd(), _path_events,
+                     sizeof(_path_events), 0);
+  io_uring_sqe_set_data(sqe, _path_index);
+  return true;
+}
+
+// 提交读主线程队列eventfd的事件，完成事件的user_data为队列
+bool IoUringServer::set_wakeup_read_event() {
+  struct io_uring_sqe *sqe = io_uring_get_sqe(_ring.get());
+  if (!sqe) {
+    io_uring_submit(_ring.get());
+    sqe = io_uring_get_sqe(_ring.get());
+    if (!sqe) {
+      return false;
+    }
+  }
+  io_uring_prep_read(sqe, _main_queue->wakeup_fd(), &_wakeup_value,
+                     sizeof(_wakeup_value), 0);
+  io_uring_sqe_set_data(sqe, _main_queue.get());
+  return true;
+}
+
+// 工作线程交回了任务：任务在本轮的process_main_thread_tasks中执行，
+// 这里只重新提交读
+void IoUringServer::handle_wakeup_event(int result) {
+  if (result < 0 && result != -EAGAIN && result != -EINTR) {
+    std::cerr << "读主线程队列eventfd失败: " << result << std::endl;
+  }
+  if (_running && !set_wakeup_read_event()) {
+    std::cerr << "重新提交主线程队列eventfd读取失败" << std::endl;
+  }
+}
+
+// 静态根目录下有文件增删：更新索引后继续读
+void IoUringServer::handle_path_watch_event(int result) {
+  size_t changed = _path_index->handle_watch_events(_path_events, result);
+  if (changed > 0) {
+    std::cout << "静态目录变化，路径索引更新" << changed << "项，共"
+              << _path_index->size() << "个文件" << std::endl;
+  }
+  if (!_path_index->enabled()) {
+    _path_index = nullptr;
+    return;
+  }
+  if (!set_path_watch_read_event()) {
+    std::cerr << "重新提交静态目录inotify读取失败，停用静态路径索引"
+              << std::endl;
+    _path_index->disable();
+    _path_index = nullptr;
+  }
+}
+
+// 被缓存的文件有变化：对应的缓存项失效，再次请求时重新打开
+void IoUringServer::handle_watch_event(int result) {
+  size_t invalidated = _file_table->handle_watch_events(result);
+  if (invalidated > 0) {
+    std::cout << "文件变化，描述符缓存失效" << invalidated << "项，剩余"
+              << _file_table->size() << "项" << std::endl;
+  }
+  if (_file_table->inotify_fd() >= 0 && !set_watch_read_event()) {
+    std::cerr << "重新提交inotify读取失败" << std::endl;
+  }
+}
+
+// OPENAT和STATX都完成（需要内容时再读完整个文件）后，把暂停的请求重新
+// 交给工作线程，由它取走结果
+void IoUringServer::handle_file_open_event(UringConnectionInfo *conn,
+                                           int result) {
+  bool continued;
+  if (conn->file_op.state == UringFileOpState::READING) {
+    continued = _task_dispatcher->file_body_read(conn, result);
+  } else {
+    if (!conn->file_op.complete(result)) {
+      return;
+    }
+    if (_file_table) {
+      _file_table->adopt(conn);
+    }
+    continued = _task_dispatcher->file_opened(conn);
+  }
+  if (!continued) {
+    std::cerr << "文件打开后无法继续处理请求，fd=" << conn->fd << std::endl;
+    conn->file_op.reset();
+    set_close_event(conn);
+  }
+}
+
 void IoUringServer::handle_read_event(UringConnectionInfo *conn,
-                                      size_t result) {
+                                      int result) {
   if (result == 0) {
     // 连接关闭
     std::cout << "handle_read---------------连接关闭: fd=" << conn->fd
               << std::endl;
     set_close_event(conn);
   } else if (result > 0) {
+    conn->last_active_time = time(nullptr);
     // 读取数据成功，判断是读到哪里的数据
-    if (conn->extra_buffer != nullptr) {
-      // 判断大小是否等于info->bytes_NO_read
-      if (result == conn->bytes_NO_read) {
+    if (conn->extra_buffer_in_use) {
+      // 判断额外缓冲区是否已经读满info->bytes_NO_read
+      conn->extra_buffer_filled += result;
+      if (conn->extra_buffer_filled == conn->bytes_NO_read) {
         conn->parse_result = ParseResult::COMPLETE;
         // 使用任务分发器处理
         bool handled = _task_dispatcher->dispatch(conn);
@@ -228,9 +451,9 @@ void IoUringServer::handle_read_event(UringConnectionInfo *conn,
       } else {
         // 数据不完整，继续读取到extra_buffer
         std::cout << "数据不完整，继续读取，fd=" << conn->fd
-                  << "，已读取=" << result << "，期望=" << conn->bytes_NO_read
-                  << std::endl;
-        set_read_event(conn);
+                  << "，已读取=" << conn->extra_buffer_filled
+                  << "，期望=" << conn->bytes_NO_read << std::endl;
+        set_extra_read_event(conn);
       }
     } else {
       conn->read_buffer.write_data(result); // 读取数据成功
@@ -246,27 +469,60 @@ void IoUringServer::handle_read_event(UringConnectionInfo *conn,
       }
     }
   } else {
-    perror("read");
-    _memory_pool->release_connection(conn);
+    // 读失败（如对端重置），关闭套接字后归还连接
+    std::cerr << "Read失败: " << result << ", fd=" << conn->fd << std::endl;
+    set_close_event(conn);
   }
 }
 
 void IoUringServer::handle_write_event(UringConnectionInfo *conn, int result) {
   if (result > 0) {
-    conn->write_buffer.read_data(result);
+    conn->last_active_time = time(nullptr);
+    conn->consume_written(result);
     std::cout << "写入数据: " << result << "字节, fd=" << conn->fd << std::endl;
 
-    // 检查是否还有数据需要写入
-    if (conn->write_buffer.get_readable_size() > 0) {
+    // 流式响应：写出后腾出的空间交给数据源继续填充
+    if (conn->response_stream.active() && !conn->response_stream.finished()) {
+      conn->pump_response_stream();
+    }
+    // 文件流的READ都已完成（链接的WRITE在它之后），可以关闭文件
+    if (conn->file_stream.active() && conn->file_stream.finished()) {
+      set_file_close_event(conn);
+    }
+
+    // 检查是否还有数据需要写入（文件流会在写之前先读入下一段）
+    if (conn->has_output()) {
       // 还有数据，继续写入
       set_write_event(conn);
+      return;
+    }
+    if (conn->response_stream.active()) {
+      // 流式响应全部写出，回收数据源和请求分配区
+      conn->finish_response_stream();
+    }
+    _task_dispatcher->release_file(conn);
+    if (conn->file_op.state == UringFileOpState::REQUESTED) {
+      // 之前的响应都已写出，轮到等待打开文件的请求
+      if (!_task_dispatcher->start_file_open(conn)) {
+        conn->file_op.reset();
+        set_close_event(conn);
+      }
+    } else if (!conn->keep_alive) {
+      // 最后一个字节已写出，立即半关闭并关闭，尽快回收连接
+      set_shutdown_event(conn);
+    } else if (!conn->read_buffer.is_empty()) {
+      // 流水线中还有因写缓冲区不足而暂停的请求，先处理它们
+      bool handled = _task_dispatcher->dispatch(conn);
+      if (!handled) {
+        set_read_event(conn);
+      }
     } else {
       // 数据写入完成，继续读取下一个请求
       set_read_event(conn);
     }
   } else {
     std::cerr << "Write失败: " << result << ", fd=" << conn->fd << std::endl;
-    _memory_pool->release_connection(conn);
+    set_close_event(conn);
   }
 }
 
@@ -281,6 +537,16 @@ void IoUringServer::process_main_thread_tasks() {
   }
 }
 
+// 事件循环的周期维护：按水位回收内存池
+void IoUringServer::run_maintenance() {
+  _last_maintenance = std::chrono::steady_clock::now();
+  size_t released = _memory_pool->trim(_trim_policy);
+  if (released > 0) {
+    std::cout << "内存回收: 归还" << released << "字节, 当前常驻约"
+              << _memory_pool->get_resident_bytes() << "字节" << std::endl;
+  }
+}
+
 void IoUringServer::run() {
   int listen_fd = _tcp_listener->get_listen_fd();
   if (listen_fd < 0) {
@@ -300,13 +566,48 @@ void IoUringServer::run() {
   _task_dispatcher->register_handler(
       std::make_unique<DefaultFileHandler<UringConnectionInfo>>());
   _running = true;
+  if (_file_table && !set_watch_read_event()) {
+    std::cerr << "提交inotify读取失败" << std::endl;
+  }
+  if (!set_wakeup_read_event()) {
+    std::cerr << "提交主线程队列eventfd读取失败" << std::endl;
+  }
+  if (StaticPathIndex::instance().enabled()) {
+    _path_index = &StaticPathIndex::instance();
+    if (!set_path_watch_read_event()) {
+      std::cerr << "提交静态目录inotify读取失败，停用静态路径索引"
+                << std::endl;
+      _path_index->disable();
+      _path_index = nullptr;
+    }
+  }
   io_uring_submit(_ring.get());
 
   std::cout << "服务器开始运行，监听端口: " << TCP_DEFAULT_PORT << std::endl;
 
+  _last_maintenance = std::chrono::steady_clock::now();
+  const auto maintenance_interval =
+      std::chrono::milliseconds(MEMORY_TRIM_INTERVAL_MS);
+
   while (_running) {
     struct io_uring_cqe *cqe;
-    int ret = io_uring_wait_cqe(_ring.get(), &cqe);
+    // 带超时等待，空闲时也能按周期执行维护
+    struct __kernel_timespec timeout;
+    timeout.tv_sec = MEMORY_TRIM_INTERVAL_MS / 1000;
+    timeout.tv_nsec = (MEMORY_TRIM_INTERVAL_MS % 1000) * 1000000L;
+    int ret = io_uring_wait_cqe_timeout(_ring.get(), &cqe, &timeout);
+
+    // 秒数变化时刷新响应用的Date头部，工作线程只读缓存
+    HttpDateCache::instance().update(std::time(nullptr));
+
+    if (std::chrono::steady_clock::now() - _last_maintenance >=
+        maintenance_interval) {
+      run_maintenance();
+    }
+
+    if (ret == -ETIME) {
+      continue;
+    }
 
     if (ret == 0) {
       process_completion_events();